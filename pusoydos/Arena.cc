@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+
+#include "Arena.h"
+
+namespace pusoydos {
+
+const size_t Arena::sDefaultBlockSize;
+
+Arena::Arena(const size_t blockSize)
+    : _blockSize(blockSize),
+      _current(0),
+      _offset(0),
+      _used(0)
+{
+}
+
+Arena::~Arena(void)
+{
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        free(_blocks[i].data);
+    }
+}
+
+void*
+Arena::allocate(const size_t size, const size_t align)
+{
+    while (_current < _blocks.size()) {
+        const Block& block = _blocks[_current];
+        size_t start = (_offset + align - 1) & ~(align - 1);
+        if (start + size <= block.size) {
+            _offset = start + size;
+            _used += size;
+            return block.data + start;
+        }
+        // later blocks kept from earlier games are tried before growing
+        ++_current;
+        _offset = 0;
+    }
+
+    Block block;
+    block.size = std::max(_blockSize, size + align);
+    block.data = (char*)malloc(block.size);
+    if (block.data == NULL) {
+        throw std::bad_alloc();
+    }
+    _blocks.push_back(block);
+    _current = _blocks.size() - 1;
+    // malloc alignment covers all fundamental types
+    _offset = size;
+    _used += size;
+    return block.data;
+}
+
+void
+Arena::reset(void)
+{
+    _current = 0;
+    _offset = 0;
+    _used = 0;
+}
+
+size_t
+Arena::getCapacity(void) const
+{
+    size_t capacity = 0;
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        capacity += _blocks[i].size;
+    }
+    return capacity;
+}
+
+size_t
+Arena::getUsed(void) const
+{
+    return _used;
+}
+
+} /* namespace pusoydos */
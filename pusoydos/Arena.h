@@ -0,0 +1,81 @@
+#ifndef _PUSOYDOS_ARENA_H_
+#define _PUSOYDOS_ARENA_H_
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pusoydos {
+
+// bump allocator for storage that lives for one game: an allocation is a
+// pointer bump, nothing is freed on its own, and reset() recycles all of
+// it at once but keeps the blocks. Once a few games have been played
+// nothing more is taken from the heap and the footprint stays flat.
+// Not thread-safe, each owner uses its arena from one thread.
+class Arena
+{
+  public:
+    Arena(const size_t blockSize = sDefaultBlockSize);
+
+    ~Arena(void);
+
+    void* allocate(const size_t size, const size_t align);
+
+    // precondition: nothing allocated since the last reset is used again
+    void reset(void);
+
+    // bytes held in blocks / handed out since the last reset
+    size_t getCapacity(void) const;
+    size_t getUsed(void) const;
+
+    static const size_t sDefaultBlockSize = 64 * 1024;
+
+  private:
+    class Block
+    {
+      public:
+        char*  data;
+        size_t size;
+    };
+
+    std::vector<Block> _blocks;
+    size_t _blockSize;
+    // block allocations are served from, and offset into it
+    size_t _current;
+    size_t _offset;
+    size_t _used;
+
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+};
+
+// standard allocator over an arena, deallocation is a no-op; containers
+// using it must be emptied (capacity included) before the arena is reset
+template <typename T>
+class ArenaAllocator
+{
+  public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena* arena) : _arena(arena) { }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.getArena()) { }
+
+    T* allocate(const size_t n) { return (T*)_arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, const size_t) { }
+
+    Arena* getArena(void) const { return _arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return _arena == other.getArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return _arena != other.getArena(); }
+
+  private:
+    Arena* _arena;
+};
+
+} /* namespace pusoydos */
+
+#endif
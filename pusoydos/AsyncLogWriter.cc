@@ -0,0 +1,225 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include "AsyncLogWriter.h"
+
+namespace pusoydos {
+
+const size_t AsyncLogWriter::sDefaultBufferSize;
+
+/****************************************************
+ ******************** Channel ***********************
+ ****************************************************/
+
+AsyncLogWriter::Channel::Channel(AsyncLogWriter* writer, const size_t bufferSize)
+    : _writer(writer),
+      _fill(0),
+      _pending(-1)
+{
+    for (uint16_t i = 0; i < 2; ++i) {
+        _buffers[i].resize(bufferSize);
+        _used[i] = 0;
+    }
+}
+
+AsyncLogWriter::Channel::~Channel(void)
+{
+}
+
+bool
+AsyncLogWriter::Channel::append(const char* data, const size_t size)
+{
+    if (size > _buffers[_fill].size() ||
+        (_used[_fill] + size > _buffers[_fill].size() && !_submit())) {
+        _writer->_numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    memcpy(_buffers[_fill].data() + _used[_fill], data, size);
+    _used[_fill] += size;
+    return true;
+}
+
+bool
+AsyncLogWriter::Channel::flush(void)
+{
+    return _submit();
+}
+
+bool
+AsyncLogWriter::Channel::_submit(void)
+{
+    if (_used[_fill] == 0) {
+        return true;
+    }
+    if (_pending.load(std::memory_order_acquire) != -1) {
+        // the writer has not finished the other buffer yet
+        if (_writer->_policy == kDrop) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(_writer->_mutex);
+        _writer->_wake.notify_one();
+        _writer->_written.wait(lock, [this] {
+            return _pending.load(std::memory_order_acquire) == -1;
+        });
+    }
+    _pending.store(_fill, std::memory_order_release);
+    _fill ^= 1;
+    _used[_fill] = 0;
+    // no lock: a missed wakeup only delays the write until the next poll
+    _writer->_wake.notify_one();
+    return true;
+}
+
+/****************************************************
+ ***************** AsyncLogWriter *******************
+ ****************************************************/
+
+AsyncLogWriter::AsyncLogWriter(const std::string& path, const OverflowT policy,
+                               const size_t bufferSize)
+    : _fd(-1),
+      _policy(policy),
+      _bufferSize(bufferSize),
+      _stopping(false),
+      _numDropped(0),
+      _bytesWritten(0),
+      _error(0)
+{
+    _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (_fd < 0) {
+        throw std::runtime_error("cannot open log file " + path + ": " + strerror(errno));
+    }
+    _thread = std::thread(&AsyncLogWriter::_run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter(void)
+{
+    _stopping.store(true);
+    _wake.notify_one();
+    _thread.join();
+
+    // pending buffers first, they hold the older records of their channel
+    _drain();
+    for (size_t i = 0; i < _channels.size(); ++i) {
+        Channel* channel = _channels[i];
+        if (channel->_used[channel->_fill] > 0) {
+            struct iovec v = { channel->_buffers[channel->_fill].data(), channel->_used[channel->_fill] };
+            _iov.push_back(v);
+        }
+    }
+    _write();
+    close(_fd);
+    for (size_t i = 0; i < _channels.size(); ++i) {
+        delete _channels[i];
+    }
+}
+
+AsyncLogWriter::Channel*
+AsyncLogWriter::openChannel(void)
+{
+    Channel* channel = new Channel(this, _bufferSize);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _channels.push_back(channel);
+    return channel;
+}
+
+AsyncLogWriter::OverflowT
+AsyncLogWriter::getPolicy(void) const
+{
+    return _policy;
+}
+
+uint64_t
+AsyncLogWriter::getNumDropped(void) const
+{
+    return _numDropped.load(std::memory_order_relaxed);
+}
+
+uint64_t
+AsyncLogWriter::getBytesWritten(void) const
+{
+    return _bytesWritten.load(std::memory_order_relaxed);
+}
+
+int
+AsyncLogWriter::getError(void) const
+{
+    return _error.load(std::memory_order_relaxed);
+}
+
+void
+AsyncLogWriter::_run(void)
+{
+    while (!_stopping.load()) {
+        if (!_drain()) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+}
+
+bool
+AsyncLogWriter::_drain(void)
+{
+    _drained.clear();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _channels.size(); ++i) {
+            Channel* channel = _channels[i];
+            int pending = channel->_pending.load(std::memory_order_acquire);
+            if (pending != -1) {
+                struct iovec v = { channel->_buffers[pending].data(), channel->_used[pending] };
+                _iov.push_back(v);
+                _drained.push_back(channel);
+            }
+        }
+    }
+    if (_drained.empty()) {
+        return false;
+    }
+    _write();
+    {
+        // under the lock, so a blocked producer cannot miss the wakeup
+        // between checking its buffer and waiting
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _drained.size(); ++i) {
+            _drained[i]->_pending.store(-1, std::memory_order_release);
+        }
+    }
+    _written.notify_all();
+    return true;
+}
+
+void
+AsyncLogWriter::_write(void)
+{
+    size_t next = 0;
+    while (next < _iov.size() && _error.load(std::memory_order_relaxed) == 0) {
+        int count = std::min<size_t>(_iov.size() - next, IOV_MAX);
+        ssize_t n = writev(_fd, &_iov[next], count);
+        if (n < 0) {
+            if (errno != EINTR) {
+                _error.store(errno, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        _bytesWritten.fetch_add(n, std::memory_order_relaxed);
+        // skip what was written, finishing a partly written buffer next
+        while (next < _iov.size() && (size_t)n >= _iov[next].iov_len) {
+            n -= _iov[next].iov_len;
+            ++next;
+        }
+        if (n > 0) {
+            _iov[next].iov_base = (char*)_iov[next].iov_base + n;
+            _iov[next].iov_len -= n;
+        }
+    }
+    _iov.clear();
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,108 @@
+#ifndef _PUSOYDOS_ASYNCLOGWRITER_H_
+#define _PUSOYDOS_ASYNCLOGWRITER_H_
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <vector>
+#include <condition_variable>
+#include <stdint.h>
+#include <sys/uio.h>
+
+namespace pusoydos {
+
+// appends text (transcripts, logs) to a local file from a background
+// thread. Every producing thread opens its own Channel: a pair of staging
+// buffers it fills without locks while the writer thread drains the other
+// one, so game threads never wait on the file. Full buffers of all
+// channels are written together with writev. Memory is bounded by two
+// buffers per channel; what happens when the writer falls behind is set
+// by the overflow policy.
+class AsyncLogWriter
+{
+  public:
+    typedef enum {
+        kBlock = 0,  // producer sleeps until its other buffer is written
+        kDrop  = 1   // the record is dropped and counted
+    } OverflowT;
+
+    // staging buffers of one producing thread; only that thread may call
+    // append() and flush()
+    class Channel
+    {
+      public:
+        // appends a whole record (e.g. a line); false if it was dropped.
+        // Records longer than the buffer size are always dropped.
+        bool append(const char* data, const size_t size);
+        bool append(const std::string& record) { return append(record.data(), record.size()); }
+
+        // hands the filled part of the buffer to the writer
+        bool flush(void);
+
+      private:
+        friend class AsyncLogWriter;
+
+        Channel(AsyncLogWriter* writer, const size_t bufferSize);
+        ~Channel(void);
+
+        AsyncLogWriter* _writer;
+        std::vector<char> _buffers[2];
+        size_t _used[2];
+        // buffer the producer fills
+        uint16_t _fill;
+        // buffer waiting for the writer, -1 if none; the producer sets it,
+        // the writer clears it once the buffer is written
+        std::atomic<int> _pending;
+
+        bool _submit(void);
+    };
+
+    // opens (creating if needed) path for appending
+    AsyncLogWriter(const std::string& path, const OverflowT policy = kBlock,
+                   const size_t bufferSize = sDefaultBufferSize);
+
+    // writes everything appended so far; producers must have stopped
+    ~AsyncLogWriter(void);
+
+    // new channel for the calling thread, owned by the writer
+    Channel* openChannel(void);
+
+    OverflowT getPolicy(void) const;
+    uint64_t getNumDropped(void) const;
+    uint64_t getBytesWritten(void) const;
+    // errno of the first failed write, 0 if none (writing stops after it)
+    int getError(void) const;
+
+    static const size_t sDefaultBufferSize = 256 * 1024;
+
+  private:
+    int       _fd;
+    OverflowT _policy;
+    size_t    _bufferSize;
+
+    std::vector<Channel*> _channels;
+    // guards the channel list, the writer's sleep and blocked producers
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    // a drain finished, producers waiting for their other buffer (kBlock)
+    // look again
+    std::condition_variable _written;
+    std::atomic<bool> _stopping;
+    std::atomic<uint64_t> _numDropped;
+    std::atomic<uint64_t> _bytesWritten;
+    std::atomic<int> _error;
+    // iovecs of one drain, only used by the writer thread
+    std::vector<struct iovec> _iov;
+    std::vector<Channel*> _drained;
+    std::thread _thread;
+
+    void _run(void);
+    // writes the pending buffers of all channels, false if there were none
+    bool _drain(void);
+    void _write(void);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,101 @@
+#include <time.h>
+#include <iomanip>
+#include <algorithm>
+
+#include "Benchmark.h"
+
+namespace pusoydos {
+
+std::atomic<uint64_t> Benchmark::sAllocations(0);
+
+static double
+monotonicSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+Benchmark::Benchmark(const double minSeconds, const uint16_t numRepetitions)
+    : _minSeconds(minSeconds),
+      _numRepetitions(std::max<uint16_t>(1, numRepetitions))
+{
+}
+
+void
+Benchmark::setFilter(const std::string& filter)
+{
+    _filter = filter;
+}
+
+bool
+Benchmark::run(const std::string& name, const BatchFn& batch)
+{
+    if (name.find(_filter) == std::string::npos) {
+        return false;
+    }
+
+    // calibrate: grow the batch until one run takes a tenth of a repetition,
+    // which also warms caches and branch predictors
+    uint64_t n = 1;
+    double elapsed = 0.0;
+    for (;;) {
+        double start = monotonicSeconds();
+        batch(n);
+        elapsed = monotonicSeconds() - start;
+        if (elapsed >= _minSeconds / 10 || n >= (1ULL << 40)) {
+            break;
+        }
+        double grow = (elapsed > 0.0) ? _minSeconds / 10 / elapsed : 10.0;
+        n = n * std::min(10.0, std::max(2.0, grow));
+    }
+    if (elapsed > 0.0) {
+        n = std::max<uint64_t>(1, n * (_minSeconds / elapsed));
+    }
+
+    std::vector<double> nsPerOp(_numRepetitions);
+    uint64_t allocs = 0;
+    for (uint16_t r = 0; r < _numRepetitions; ++r) {
+        uint64_t allocStart = sAllocations.load(std::memory_order_relaxed);
+        double start = monotonicSeconds();
+        batch(n);
+        nsPerOp[r] = (monotonicSeconds() - start) * 1e9 / n;
+        allocs += sAllocations.load(std::memory_order_relaxed) - allocStart;
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = n;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.allocsPerOp = (double)allocs / (n * _numRepetitions);
+    result.opsPerSec = (result.nsPerOp > 0.0) ? 1e9 / result.nsPerOp : 0.0;
+    _results.push_back(result);
+    return true;
+}
+
+const std::vector<Benchmark::Result>&
+Benchmark::getResults(void) const
+{
+    return _results;
+}
+
+void
+Benchmark::printJson(std::ostream& os) const
+{
+    // names are plain identifiers, nothing to escape
+    os << "{\n  \"format\": 1,\n  \"benchmarks\": [";
+    for (size_t i = 0; i < _results.size(); ++i) {
+        const Result& r = _results[i];
+        os << (i ? ",\n" : "\n")
+           << "    {\"name\": \"" << r.name << "\""
+           << ", \"iterations\": " << r.iterations
+           << std::fixed
+           << ", \"ns_per_op\": " << std::setprecision(2) << r.nsPerOp
+           << ", \"allocs_per_op\": " << std::setprecision(3) << r.allocsPerOp
+           << ", \"ops_per_sec\": " << std::setprecision(1) << r.opsPerSec << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,68 @@
+#ifndef _PUSOYDOS_BENCHMARK_H_
+#define _PUSOYDOS_BENCHMARK_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <stdint.h>
+
+namespace pusoydos {
+
+// microbenchmark runner: every case is timed over a number of repetitions
+// of a calibrated batch and reports the median ns/op, heap allocations/op
+// and ops/sec. Cases must draw their inputs from fixed seeds so runs of
+// different builds time the same work.
+class Benchmark
+{
+  public:
+    class Result
+    {
+      public:
+        std::string name;
+        uint64_t    iterations;  // per repetition
+        double      nsPerOp;     // median over repetitions
+        double      allocsPerOp;
+        double      opsPerSec;
+    };
+
+    // runs op n times
+    typedef std::function<void(const uint64_t n)> BatchFn;
+
+    // each repetition runs for about minSeconds
+    Benchmark(const double minSeconds = 0.2, const uint16_t numRepetitions = 5);
+
+    // cases whose name does not contain filter are skipped (empty for all)
+    void setFilter(const std::string& filter);
+
+    // times batch and keeps its result, false if filtered out
+    bool run(const std::string& name, const BatchFn& batch);
+
+    const std::vector<Result>& getResults(void) const;
+
+    // {"format": 1, "benchmarks": [{"name": ..., "iterations": ...,
+    //  "ns_per_op": ..., "allocs_per_op": ..., "ops_per_sec": ...}, ...]}
+    void printJson(std::ostream& os) const;
+
+    // keeps the compiler from dropping a computed value
+    template <typename T>
+    static void keep(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // heap allocations so far; counted by the benchmark binary's operator
+    // new (see pusoydosbench.cc), always 0 in other binaries
+    static std::atomic<uint64_t> sAllocations;
+
+  private:
+    double   _minSeconds;
+    uint16_t _numRepetitions;
+    std::string _filter;
+    std::vector<Result> _results;
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef _PUSOYDOS_CARDSET_H_
+#define _PUSOYDOS_CARDSET_H_
+
+#include <stdint.h>
+
+namespace pusoydos {
+
+// set of cards as a 52-bit mask, one bit per card. Card codes are ordered
+// by pusoy dos rank then suit rank: code = rank * 4 + suit, where rank 0 is
+// a 3 and rank 12 a 2, and suit 0 is the lowest suit (clubs). A higher code
+// is always a higher card, so card order is plain integer order.
+class CardSet
+{
+  public:
+    typedef uint64_t MaskT;
+
+    static const uint16_t sNumRanks = 13;
+    static const uint16_t sNumSuits = 4;
+    static const uint16_t sNumCards = 52;
+    static const MaskT    sFullMask = (1ULL << 52) - 1;
+    // one bit per rank, lowest suit
+    static const MaskT    sSuitMask = 0x0001111111111111ULL;
+
+    CardSet(void) : _mask(0) { }
+    explicit CardSet(const MaskT mask) : _mask(mask) { }
+
+    static uint8_t makeCode(const uint16_t rank, const uint16_t suit) { return rank * 4 + suit; }
+    static uint16_t getRank(const uint8_t code) { return code >> 2; }
+    static uint16_t getSuit(const uint8_t code) { return code & 3; }
+    static MaskT getBit(const uint8_t code) { return 1ULL << code; }
+
+    MaskT getMask(void) const { return _mask; }
+
+    bool has(const uint8_t code) const { return (_mask & getBit(code)) != 0; }
+    bool contains(const CardSet& other) const { return (_mask & other._mask) == other._mask; }
+    void add(const uint8_t code) { _mask |= getBit(code); }
+    void remove(const uint8_t code) { _mask &= ~getBit(code); }
+    void add(const CardSet& other) { _mask |= other._mask; }
+    void remove(const CardSet& other) { _mask &= ~other._mask; }
+    void clear(void) { _mask = 0; }
+
+    bool empty(void) const { return _mask == 0; }
+    uint16_t size(void) const { return __builtin_popcountll(_mask); }
+
+    // precondition: set not empty
+    uint8_t lowest(void) const { return __builtin_ctzll(_mask); }
+    uint8_t highest(void) const { return 63 - __builtin_clzll(_mask); }
+
+    // code of the index-th lowest card (cards in ascending order)
+    uint8_t nth(uint16_t index) const
+    {
+        MaskT m = _mask;
+        while (index-- > 0) {
+            m &= m - 1;
+        }
+        return __builtin_ctzll(m);
+    }
+
+    CardSet getRankCards(const uint16_t rank) const { return CardSet(_mask & (0xFULL << (rank * 4))); }
+    CardSet getSuitCards(const uint16_t suit) const { return CardSet(_mask & (sSuitMask << suit)); }
+    uint16_t getRankCount(const uint16_t rank) const { return __builtin_popcountll(_mask & (0xFULL << (rank * 4))); }
+
+    // per-rank card counts packed in nibbles (nibble r = count of rank r)
+    MaskT getRankCounts(void) const
+    {
+        MaskT m = _mask - ((_mask >> 1) & 0x5555555555555555ULL);
+        return (m & 0x3333333333333333ULL) + ((m >> 2) & 0x3333333333333333ULL);
+    }
+
+    // 13-bit mask with bit r set if any card of rank r is in the set
+    uint16_t getRankMask(void) const
+    {
+        return _compressRanks((_mask | (_mask >> 1) | (_mask >> 2) | (_mask >> 3)) & sSuitMask);
+    }
+
+    // 13-bit mask of ranks held exactly n times (0 <= n <= 4)
+    uint16_t getRanksWithCount(const uint16_t n) const
+    {
+        // nibbles equal to n become zero; flag zero nibbles in their low bit
+        MaskT y = getRankCounts() ^ (n * sSuitMask);
+        MaskT t = (y & 0x7777777777777777ULL) + 0x7777777777777777ULL;
+        t = ~(t | y | 0x7777777777777777ULL) & (sSuitMask << 3);
+        return _compressRanks(t >> 3);
+    }
+
+    CardSet operator|(const CardSet& rhs) const { return CardSet(_mask | rhs._mask); }
+    CardSet operator&(const CardSet& rhs) const { return CardSet(_mask & rhs._mask); }
+    CardSet operator-(const CardSet& rhs) const { return CardSet(_mask & ~rhs._mask); }
+    bool operator==(const CardSet& rhs) const { return _mask == rhs._mask; }
+    bool operator!=(const CardSet& rhs) const { return _mask != rhs._mask; }
+
+  private:
+    MaskT _mask;
+
+    // gathers bit 4r of a nibble-aligned mask into bit r
+    static uint16_t _compressRanks(MaskT m)
+    {
+        uint16_t ranks = 0;
+        for (; m; m &= m - 1) {
+            ranks |= 1 << (__builtin_ctzll(m) >> 2);
+        }
+        return ranks;
+    }
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -2,57 +2,43 @@
 #include <sstream>
 #include <stdexcept>
 #include <iomanip>
+#include <algorithm>
+#include <type_traits>
 
 #include "Combo.h"
+#include "ComboClassifier.h"
 
 namespace pusoydos {
 
-const uint16_t Combo::sMaxComboSize = 5;
+static_assert(sizeof(Combo) <= 16, "Combo must stay within 16 bytes");
+static_assert(std::is_trivially_copyable<Combo>::value, "Combo must be trivially copyable");
 
-Combo::Combo(const ComboT type)
-    : _name(""), _type(type)
-{
-}
-
-Combo::Combo(const std::string name, const ComboT type)
-    : _name(name), _type(type)
-{
-}
-
-Combo::Combo(const Combo& other)
-    : _name(other._name), _type(other._type)
-{
-    _cardCombo.assign(other._cardCombo.begin(), other._cardCombo.end());
-}
+const uint8_t Combo::sNoOwner;
+const uint16_t Combo::sMaxComboSize;
 
-Combo&
-Combo::operator=(const Combo& other)
+Combo::Combo(const ComboT type)
+    : _size(0), _type(type), _owner(sNoOwner), _key(0)
 {
-    if (this != &other) {
-        _cardCombo.assign(other._cardCombo.begin(), other._cardCombo.end());
-        _name = other._name;
-        _type = other._type;
-    }
-    return *this;
 }
 
 void
 Combo::setType(const ComboT type)
 {
     _type = type;
+    _updateKey();
 }
 
 Combo::ComboT
 Combo::getType(void) const
 {
-    return _type;
+    return (ComboT)_type;
 }
 
 bool
-Combo::addCard(CardPtr card)
+Combo::addCard(const uint8_t code)
 {
     bool valid = true;
-    uint16_t size = _cardCombo.size();
+    uint16_t size = _size;
     switch (_type) {
       case kSingle:
         if (size > 0) {
@@ -66,7 +52,7 @@ Combo::addCard(CardPtr card)
             return false;
         }
         else if (size == 1) {
-            valid = (card->getNumber() == _cardCombo[0]->getNumber());
+            valid = (CardSet::getRank(code) == CardSet::getRank(_cards[0]));
             if (!valid) {
                 std::cerr << "cards in pair must be of same rank\n";
             }
@@ -78,7 +64,7 @@ Combo::addCard(CardPtr card)
             return false;
         }
         else if (size == 1 || size == 2) {
-            valid = (card->getNumber() == _cardCombo[0]->getNumber());
+            valid = (CardSet::getRank(code) == CardSet::getRank(_cards[0]));
             if (!valid) {
                 std::cerr << "cards in three-of-a-kind  must be of same rank\n";
             }
@@ -94,20 +80,25 @@ Combo::addCard(CardPtr card)
             return false;
         }
         else if (size == 4) {
-            _cardCombo.push_back(card);
-            return _validateFiveCardCombo();
+            _cards[_size++] = code;
+            if (!_validateFiveCardCombo()) {
+                return false;
+            }
+            _updateKey();
+            return true;
         }
         break;
       default:
         throw std::invalid_argument("cannot add card if combo type not defined");
         break;
     }
-    if (_cardCombo.size() >= sMaxComboSize) {
+    if (_size >= sMaxComboSize) {
         std::cerr << "exceeding maximum size of combo\n";
         valid = false;
     }
     if (valid) {
-        _cardCombo.push_back(card);
+        _cards[_size++] = code;
+        _updateKey();
     }
     return valid;
 }
@@ -145,148 +136,91 @@ Combo::_validateFiveCardCombo(void)
 {
     // precondition: all 5 cards must have already been added
     sort();
-    uint16_t val;
-    char suit;
-    std::map<uint16_t, uint16_t> counts;
+    if (ComboClassifier::getKey(getType(), getCardSet()) != 0) {
+        return true;
+    }
     switch (_type) {
       case kStraight:
-        val = _cardCombo[0]->getValue();
-        for (uint16_t i = 1; i < _cardCombo.size(); ++i) {
-            if (_cardCombo[i]->getValue() == val+1 ||
-                (_cardCombo[0]->getValue() == 3 &&
-                    (i == 3 && _cardCombo[i]->getValue() == 14) ||
-                    (i == 4 && _cardCombo[i]->getValue() == 15))) {
-                ++val;
-            }
-            else {
-                std::cerr << "Straight must be a set of cards with monotonically increasing value\n";
-                return false;
-            }
-        }
+        std::cerr << "Straight must be a set of cards with monotonically increasing value\n";
         break;
       case kFlush:
-        suit = _cardCombo[0]->getSuit();
-        for (uint16_t i = 1; i < _cardCombo.size(); ++i) {
-            if (_cardCombo[i]->getSuit() != suit) {
-                std::cerr << "All cards in Flush must be of same suit\n";
-                return false;
-            }
-        }
+        std::cerr << "All cards in Flush must be of same suit\n";
         break;
       case kFullHouse:
-        for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-            val = _cardCombo[i]->getValue();
-            (counts.find(val) == counts.end()) ? counts[val] = 1
-                                               : counts[val]++;
-        }
-        if (counts.size() == 2 &&
-            (counts.begin()->second == 3 || counts.rbegin()->second == 3)) {
-            return true;
-        }
-        else {
-            std::cerr << "Full House must have one pair and one three-of-a-kind\n";
-            return false;
-        }
+        std::cerr << "Full House must have one pair and one three-of-a-kind\n";
         break;
       case kFourKind:
-        for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-            val = _cardCombo[i]->getValue();
-            (counts.find(val) == counts.end()) ? counts[val] = 1
-                                               : counts[val]++;
-        }
-        if (counts.size() == 2 &&
-            (counts.begin()->second == 4 || counts.rbegin()->second == 4)) {
-            return true;
-        }
-        else {
-            std::cerr << "Four-of-a-kind must have four cards of the same value\n";
-            return false;
-        }
+        std::cerr << "Four-of-a-kind must have four cards of the same value\n";
         break;
       case kStraightFlush:
-        suit = _cardCombo[0]->getSuit();
-        for (uint16_t i = 1; i < _cardCombo.size(); ++i) {
-            if (_cardCombo[i]->getSuit() != suit) {
-                std::cerr << "All cards in Straight Flush must be of same suit\n";
-                return false;
-            }
-        }
-        val = _cardCombo[0]->getValue();
-        for (uint16_t i = 1; i < _cardCombo.size(); ++i) {
-            if (_cardCombo[i]->getValue() == val+1 ||
-                (_cardCombo[0]->getValue() == 3 &&
-                    (i == 3 && _cardCombo[i]->getValue() == 14) ||
-                    (i == 4 && _cardCombo[i]->getValue() == 15))) {
-                ++val;
-            }
-            else {
-                std::cerr << "Straight Flush must be a set of cards with monotonically increasing value\n";
-                return false;
-            }
-        }
+        std::cerr << "Straight Flush must be a set of cards of the same suit with monotonically increasing value\n";
         break;
       default:
-        return false;
         break;
     }
-    return true;
+    return false;
 }
 
-const CardPtr&
+uint8_t
 Combo::getCard(const uint16_t index) const
 {
-    return _cardCombo.at(index);
+    if (index >= _size) {
+        throw std::out_of_range("invalid combo card index");
+    }
+    return _cards[index];
 }
 
 void
-Combo::setCardCombo(const std::vector<CardPtr>& cardCombo)
+Combo::setCards(const CardSet& cards)
 {
-    if (cardCombo.size() > sMaxComboSize) {
+    if (cards.size() > sMaxComboSize) {
         throw std::invalid_argument("exceeding maximum size of combo");
     }
-    _cardCombo.assign(cardCombo.begin(), cardCombo.end());
+    _size = 0;
+    for (CardSet::MaskT m = cards.getMask(); m; m &= m - 1) {
+        _cards[_size++] = __builtin_ctzll(m);
+    }
+    _updateKey();
 }
 
-const std::vector<CardPtr>&
-Combo::getCardCombo(void) const
+CardSet
+Combo::getCardSet(void) const
 {
-    return _cardCombo;
+    CardSet cards;
+    for (uint16_t i = 0; i < _size; ++i) {
+        cards.add(_cards[i]);
+    }
+    return cards;
 }
 
 uint16_t
 Combo::getSize(void) const
 {
-    return _cardCombo.size();
+    return _size;
 }
 
-const CardPtr&
+uint8_t
 Combo::highCard(void) const
 {
-    SuitList suits = Card::getSuitList();
-    return (*std::max_element(_cardCombo.begin(),
-                              _cardCombo.end(),
-                              CompareCards(suits)));
+    return *std::max_element(_cards, _cards + _size);
 }
 
-const CardPtr&
+uint8_t
 Combo::lowCard(void) const
 {
-    SuitList suits = Card::getSuitList();
-    return (*std::min_element(_cardCombo.begin(),
-                              _cardCombo.end(),
-                              CompareCards(suits)));
+    return *std::min_element(_cards, _cards + _size);
 }
 
 void
-Combo::setOwner(const std::string name)
+Combo::setOwner(const uint8_t seat)
 {
-    _name = name;
+    _owner = seat;
 }
 
-const std::string&
+uint8_t
 Combo::getOwner(void) const
 {
-    return _name;
+    return _owner;
 }
 
 std::string
@@ -325,13 +259,15 @@ Combo::getComboTypeString(ComboT type)
 }
 
 std::ostream&
-Combo::printToStream(std::ostream& os)
-{
-    sort();
-    os << std::setw(20) << std::right << _name << " | "
-       << std::setw(16) << std::left << getComboTypeString(_type) << "  ";
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        _cardCombo[i]->printToStream(os);
+Combo::printToStream(std::ostream& os, const Rules& rules,
+                     const std::string& owner) const
+{
+    Combo sorted(*this);
+    sorted.sort();
+    os << std::setw(20) << std::right << owner << " | "
+       << std::setw(16) << std::left << getComboTypeString(getType()) << "  ";
+    for (uint16_t i = 0; i < sorted._size; ++i) {
+        rules.getCard(sorted._cards[i])->printToStream(os);
         os << " ";
     }
     os << "\n";
@@ -341,275 +277,147 @@ Combo::printToStream(std::ostream& os)
 void
 Combo::sort(void)
 {
-    SuitList suits = Card::getSuitList();
-    std::sort(_cardCombo.begin(), _cardCombo.end(), CompareCards(suits));
+    std::sort(_cards, _cards + _size);
 }
 
 bool
 Combo::operator<(const Combo& rhs) const
 {
-    if (_cardCombo.size() == 0) {
+    if (_size == 0) {
         return false;
     }
     if (_type != rhs._type) {
         return (_type < rhs._type);
     }
-    SuitList suits = Card::getSuitList();
-    CardPtr lHigh = highCard();
-    CardPtr rHigh = rhs.highCard();
-    if (lHigh.get() == NULL ||
-        rHigh.get() == NULL) {
+    if (_key == 0 || rhs._key == 0) {
         throw std::invalid_argument("cannot compare combos");
     }
+    return (_key < rhs._key);
+}
+
+uint32_t
+Combo::getKey(void) const
+{
+    return _key;
+}
+
+void
+Combo::_updateKey(void)
+{
+    _key = 0;
+    if (_size == 0 || _type >= NUMTYPES) {
+        return;
+    }
+    uint32_t strength = 0;
     switch (_type) {
-      case kThreeKind:
-        if (_cardCombo.size() < 3) {
-            throw std::invalid_argument("cannot compare combos");
-        }
-      case kPair:
-        if (_cardCombo.size() < 2) {
-            throw std::invalid_argument("cannot compare combos");
-        }
       case kSingle:
-        if (_cardCombo.size() < 1) {
-            throw std::invalid_argument("cannot compare combos");
-        }
-        // 1, 2, 3 or straight combo
-        return (lHigh->getValue() < rHigh->getValue() ||
-                    (lHigh->getValue() == rHigh->getValue() &&
-                     suits[lHigh->getSuit()] < suits[rHigh->getSuit()]));
-                        
-        break;
-      case kStraight:
-      case kStraightFlush:
-        if (_cardCombo.size() < 5) {
-            throw std::invalid_argument("cannot compare combos");
-        }
-        // ace is low card in straight
-        if (hasCard(Card::Ace) && lowCard()->getValue() == 3) {
-            // since 2 has internally highest value, 3 is lowest value card
-            lHigh = findHighCardInAceLowStraight(_cardCombo);
-        }
-        if (rhs.hasCard(Card::Ace) && rhs.lowCard()->getValue() == 3) {
-            // since 2 has internally highest value, 3 is lowest value card
-            rHigh = findHighCardInAceLowStraight(rhs.getCardCombo());
+      case kPair:
+      case kThreeKind:
+        if (_size < getNumCardsInCombo(getType())) {
+            return;
         }
-        return (lHigh->getValue() < rHigh->getValue() ||
-                    (lHigh->getValue() == rHigh->getValue() &&
-                     suits[lHigh->getSuit()] < suits[rHigh->getSuit()]));
+        // higher code is higher value, suit breaks ties
+        strength = highCard();
         break;
       case kFullHouse:
       case kFourKind:
-        if (_cardCombo.size() < 5) {
-            throw std::invalid_argument("cannot compare combos");
-        }
-        if (_type == rhs._type) {
-            // only consider card that appears more than 2 times
-            uint16_t threshold = 2;
-            uint16_t lHighVal = findHighCountCard(_cardCombo, threshold);
-            uint16_t rHighVal = findHighCountCard(rhs.getCardCombo(), threshold);
-            // card value guaranteed to be higher or lower since only
-            // one deck is used
-            return (lHighVal < rHighVal);
+        if (_size < sMaxComboSize) {
+            // only the triple/quad decides, so a partially built combo
+            // (CpuPlayer adds the pair/kicker after the comparison) is enough;
+            // card rank guaranteed to be higher or lower since only one deck is used
+            uint16_t threshold = (_type == kFullHouse) ? 3 : 4;
+            uint16_t rank = _highCountRank(threshold);
+            if (rank == CardSet::sNumRanks) {
+                return;
+            }
+            strength = rank;
+            break;
         }
-        break;
+        // complete combo, falls through to the classifier
+      case kStraight:
       case kFlush:
-        if (_cardCombo.size() < 5) {
-            throw std::invalid_argument("cannot compare combos");
-        }
-        if (_type == rhs._type) {
-            ComboListT lCombo(_cardCombo);
-            ComboListT rCombo(rhs.getCardCombo());
-            while (findHighValCard(lCombo) == findHighValCard(rCombo) &&
-                   lCombo.size() > 1) {
-                lCombo.pop_back();
-                rCombo.pop_back();
-            }
-            uint16_t lHighVal = findHighValCard(lCombo);
-            uint16_t rHighVal = findHighValCard(rCombo);
-            if (lCombo.size() > 1) {
-                // at least two cards differed in value
-                return (lHighVal < rHighVal);
-            }
-            else {
-                // one or zero cards differed in value
-                if (lHighVal == rHighVal) {
-                    // all cards have same value so compare suit of last remaining card
-                    return (suits[lCombo[0]->getSuit()] < suits[rCombo[0]->getSuit()]);
-                }
-                else {
-                    // last card differed
-                    return (lHighVal < rHighVal);
-                }
-            }
+      case kStraightFlush:
+        if (_size == sMaxComboSize) {
+            _key = ComboClassifier::getKey(getType(), getCardSet());
         }
-        break;
+        return;
       default:
-        throw std::invalid_argument("cannot compare combos");
-        break;
+        return;
     }
-    return false;
+    _key = ((uint32_t)(_type + 1) << 24) | strength;
 }
 
-CardPtr
-Combo::findHighCardInAceLowStraight(const ComboListT &combo)
+void
+Combo::_assign(const ComboT type, const CardSet& cards, const uint32_t key)
 {
-    SuitList suits = Card::getSuitList();
-    ComboListT comb(combo);
-    for (ComboListT::iterator it = comb.begin();
-         it != comb.end(); ++it) {
-        if (((*it)->isFaceCard() && (*it)->getFace() == Card::Ace) ||
-            (*it)->getNumber() == 2) {
-            // remove ace and 2 (highest value card)
-            comb.erase(it--);
-        }
+    _type = type;
+    _size = 0;
+    for (CardSet::MaskT m = cards.getMask(); m; m &= m - 1) {
+        _cards[_size++] = __builtin_ctzll(m);
     }
-    // find new high card (with ace and 2 now removed)
-    return (*std::max_element(comb.begin(),
-                              comb.end(),
-                              CompareCards(suits)));
-}
-uint16_t
-Combo::findHighValCard(ComboListT& combo)
-{
-    // sort by value and suit
-    std::sort(combo.begin(), combo.end(),
-              CompareCards(Card::getSuitList()));
-    // highest value returned (suit ignored)
-    return combo.back()->getValue();
+    _key = key;
 }
 
 uint16_t
-Combo::findHighCountCard(const ComboListT& combo, const uint16_t threshold)
+Combo::_highCountRank(const uint16_t threshold) const
 {
-    std::map<uint16_t, uint16_t> cardCount;
-    for (uint16_t i = 0; i < combo.size(); ++i) {
-        uint16_t cardVal = combo.at(i)->getValue();
-        (cardCount.find(cardVal) == cardCount.end()) ? cardCount[cardVal] = 1
-                                                     : cardCount[cardVal] += 1;
-    }
-    for (std::map<uint16_t, uint16_t>::iterator it = cardCount.begin();
-         it != cardCount.end(); ++it) {
-        // return first card above threshold
-        if (it->second > threshold) {
-            return it->first;
+    // highest rank that appears at least threshold times, sNumRanks if none
+    CardSet cards = getCardSet();
+    for (int16_t rank = CardSet::sNumRanks-1; rank >= 0; --rank) {
+        if (cards.getRankCount(rank) >= threshold) {
+            return rank;
         }
     }
-    return 0;
+    return CardSet::sNumRanks;
 }
 
 bool
-Combo::hasCard(const uint16_t number) const
+Combo::hasCard(const uint8_t code) const
 {
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->getNumber() == number) {
-            return true;
-        }
-    }
-    return false;
+    return std::find(_cards, _cards + _size, code) != (_cards + _size);
 }
 
 bool
-Combo::hasCard(const uint16_t number, const char suit) const
+Combo::hasCard(const uint16_t number) const
 {
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->getNumber() == number &&
-            _cardCombo[i]->getSuit() == suit) {
-            return true;
-        }
-    }
-    return false;
+    return (hasNumOfCard(number) > 0);
 }
 
 bool
 Combo::hasCard(const char face) const
 {
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->isFaceCard() &&
-            _cardCombo[i]->getFace() == face) {
-            return true;
-        }
-    }
-    return false;
-}
-
-bool
-Combo::hasCard(const char face, const char suit) const
-{
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->isFaceCard() &&
-            _cardCombo[i]->getFace() == face &&
-            _cardCombo[i]->getSuit() == suit) {
-            return true;
-        }
-    }
-    return false;
+    return (hasNumOfCard(face) > 0);
 }
 
 uint16_t
 Combo::hasNumOfCard(const uint16_t number) const
 {
-    uint16_t numOfCard = 0;
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->getNumber() == number) {
-            ++numOfCard;
-        }
-    }
-    return numOfCard;
-}
-
-uint16_t
-Combo::hasNumOfCard(const uint16_t number, const char suit) const
-{
-    uint16_t numOfCard = 0;
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->getNumber() == number &&
-            _cardCombo[i]->getSuit() == suit) {
-            ++numOfCard;
-        }
+    if (number < 2 || number > 10) {
+        return 0;
     }
-    return numOfCard;
+    return getCardSet().getRankCount(Rules::getRankOfNumber(number));
 }
 
 uint16_t
 Combo::hasNumOfCard(const char face) const
 {
-    uint16_t numOfCard = 0;
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->isFaceCard() &&
-            _cardCombo[i]->getFace() == face) {
-            ++numOfCard;
-        }
-    }
-    return numOfCard;
-}
-
-uint16_t
-Combo::hasNumOfCard(const char face, const char suit) const
-{
-    uint16_t numOfCard = 0;
-    for (uint16_t i = 0; i < _cardCombo.size(); ++i) {
-        if (_cardCombo[i]->isFaceCard() &&
-            _cardCombo[i]->getFace() == face &&
-            _cardCombo[i]->getSuit() == suit) {
-            ++numOfCard;
-        }
-    }
-    return numOfCard;
+    return getCardSet().getRankCount(Rules::getRankOfFace(face));
 }
 
 void
 Combo::resetCards(void)
 {
-    _cardCombo.clear();
+    _size = 0;
+    _key = 0;
 }
 
 void
 Combo::resetAll(void)
 {
     _type = kUndef;
-    _name.clear();
-    _cardCombo.clear();
+    _owner = sNoOwner;
+    _size = 0;
+    _key = 0;
 }
 
 } /* namespace pusoydos */
@@ -1,23 +1,22 @@
 #ifndef _PUSOYDOS_COMBO_H_
 #define _PUSOYDOS_COMBO_H_
 
-#include <vector>
+#include <string>
+#include <ostream>
 #include <stdexcept>
+#include <stdint.h>
 
-// game
-#include "Card.h"
-
-using namespace game;
+// pusoydos
+#include "CardSet.h"
+#include "Rules.h"
 
 namespace pusoydos {
 
-// TODO: maybe derive from std::vector to simplify interface
-// and eliminate need for ComboListT
+// fixed-capacity combo of card codes (see CardSet), trivially copyable so
+// copies never allocate
 class Combo
 {
   public:
-    // TODO: rename to CardListT
-    typedef std::vector<CardPtr> ComboListT;
     typedef enum {
         kSingle        = 0,
         kPair          = 1,
@@ -31,41 +30,39 @@ class Combo
         kUndef         = 9
     } ComboT;
 
+    static const uint8_t sNoOwner = 0xFF;
+
   public:
     Combo(const ComboT type = kUndef);
-    Combo(const std::string name, const ComboT type = kUndef);
-
-    Combo(const Combo& other);
-    Combo& operator=(const Combo& other);
 
     void setType(const ComboT type);
     ComboT getType(void) const;
 
-    bool addCard(CardPtr card);
-    const CardPtr& getCard(const uint16_t index) const;
+    bool addCard(const uint8_t code);
+    uint8_t getCard(const uint16_t index) const;
 
-    void setCardCombo(const ComboListT& cardCombo);
-    const ComboListT& getCardCombo(void) const;
+    void setCards(const CardSet& cards);
+    CardSet getCardSet(void) const;
 
     uint16_t getSize(void) const;
 
-    const CardPtr& highCard(void) const;
-    const CardPtr& lowCard(void) const;
+    // card codes, precondition: combo not empty
+    uint8_t highCard(void) const;
+    uint8_t lowCard(void) const;
 
+    bool hasCard(const uint8_t code) const;
     bool hasCard(const uint16_t number) const;
-    bool hasCard(const uint16_t number, const char suit) const;
     bool hasCard(const char face) const;
-    bool hasCard(const char face, const char suit) const;
 
     uint16_t hasNumOfCard(const uint16_t number) const;
-    uint16_t hasNumOfCard(const uint16_t number, const char suit) const;
     uint16_t hasNumOfCard(const char face) const;
-    uint16_t hasNumOfCard(const char face, const char suit) const;
 
-    void setOwner(const std::string name);
-    const std::string& getOwner(void) const;
+    // seat of player that played the combo
+    void setOwner(const uint8_t seat);
+    uint8_t getOwner(void) const;
 
-    std::ostream& printToStream(std::ostream& os);
+    std::ostream& printToStream(std::ostream& os, const Rules& rules,
+                                const std::string& owner) const;
 
     void resetCards(void);
     void resetAll(void);
@@ -74,43 +71,31 @@ class Combo
 
     bool operator<(const Combo &other) const;
 
-    // sorts and returns high card
-    static uint16_t findHighValCard(ComboListT& combo);
-    static uint16_t findHighCountCard(const ComboListT& combo, const uint16_t threshold);
-
-    static CardPtr findHighCardInAceLowStraight(const ComboListT &combo);
+    // strength key, computed once the combo is complete (for full house and
+    // four-of-a-kind once the triple/quad is in): (type+1) << 24 | strength,
+    // so combos compare by a single integer compare; 0 if incomplete
+    uint32_t getKey(void) const;
 
     static uint16_t getNumCardsInCombo(ComboT type);
 
     static std::string getComboTypeString(ComboT type);
 
-    static const uint16_t sMaxComboSize;
-
-    class CompareCards : public std::binary_function<CardPtr&, CardPtr&, bool>
-    {
-      public:
-        SuitList _suitList;
-
-        CompareCards(const SuitList& suitList) : _suitList(suitList) { }
-
-        bool operator()(const CardPtr &a, const CardPtr &b)
-        {
-            if (a.get() == NULL || b.get() == NULL) {
-                throw std::runtime_error("invalid operands for card comparison");
-            }
-            return (a->getValue() < b->getValue() ||
-                        (a->getValue() == b->getValue() &&
-                         _suitList[a->getSuit()] < _suitList[b->getSuit()]));
-        }
-    };
+    static const uint16_t sMaxComboSize = 5;
 
   private:
-    ComboListT   _cardCombo;
-    std::string  _name;
-    ComboT       _type;
+    // fills in generated moves whose key is already known
+    friend class MoveGenerator;
+
+    uint8_t _cards[sMaxComboSize];
+    uint8_t _size;
+    uint8_t _type;
+    uint8_t _owner;
+    uint32_t _key;
 
     bool _validateFiveCardCombo(void);
-    CardPtr _emptyCard;
+    void _updateKey(void);
+    void _assign(const ComboT type, const CardSet& cards, const uint32_t key);
+    uint16_t _highCountRank(const uint16_t threshold) const;
 };
 
 } /* namespace pusoydos */
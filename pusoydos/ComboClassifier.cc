@@ -0,0 +1,404 @@
+#if defined(__x86_64__) || defined(__i386__)
+#define PUSOYDOS_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+#include "ComboClassifier.h"
+
+namespace pusoydos {
+
+namespace {
+
+const uint16_t sRankMaskSize = 1 << CardSet::sNumRanks;
+
+// rank masks of the straights that wrap around the 2: A-2-3-4-5 and 2-3-4-5-6
+const uint16_t sAceLowStraight = 0x1807;
+const uint16_t sDeuceLowStraight = 0x100F;
+
+class RankTables
+{
+  public:
+    // high rank + 1 of the straight formed by a rank mask, 0 if none
+    uint8_t  straightHigh[sRankMaskSize];
+    // ranks of a five-rank mask packed from the top in 4-bit digits
+    uint32_t digits[sRankMaskSize];
+};
+
+constexpr RankTables
+makeRankTables(void)
+{
+    RankTables tables{};
+    for (uint16_t ranks = 0; ranks < sRankMaskSize; ++ranks) {
+        uint16_t numRanks = 0;
+        uint32_t digits = 0;
+        for (int16_t rank = CardSet::sNumRanks-1; rank >= 0; --rank) {
+            if (ranks & (1 << rank)) {
+                ++numRanks;
+                digits = (digits << 4) | rank;
+            }
+        }
+        if (numRanks != Combo::sMaxComboSize) {
+            continue;
+        }
+        tables.digits[ranks] = digits;
+        if (ranks == sAceLowStraight) {
+            // ace and 2 are low, 5 is high
+            tables.straightHigh[ranks] = 2 + 1;
+        }
+        else if (ranks == sDeuceLowStraight) {
+            // 2 is low, 6 is high
+            tables.straightHigh[ranks] = 3 + 1;
+        }
+        else {
+            for (uint16_t low = 0; low + 4 < CardSet::sNumRanks; ++low) {
+                if (ranks == (0x1F << low)) {
+                    tables.straightHigh[ranks] = low + 4 + 1;
+                }
+            }
+        }
+    }
+    return tables;
+}
+
+constexpr RankTables sRankTables = makeRankTables();
+
+// suit + 1 by mask of suits present (bit s set if suit s present), 0 unless
+// exactly one suit is present
+constexpr uint8_t sSingleSuit[16] = {
+    0, 1, 2, 0, 3, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0
+};
+
+typedef enum {
+    kDistinctShape  = 0,
+    kFullHouseShape = 1,
+    kFourKindShape  = 2,
+    kOtherShape     = 3
+} ShapeT;
+
+// five-card rank multisets hash perfectly onto their number of same-rank
+// card pairs: 0 five distinct ranks, 1 pair, 2 two pair, 3 three-of-a-kind,
+// 4 full house, 6 four-of-a-kind
+constexpr uint8_t sShapeByPairs[7] = {
+    kDistinctShape, kOtherShape, kOtherShape, kOtherShape,
+    kFullHouseShape, kOtherShape, kFourKindShape
+};
+
+inline uint16_t
+getSuitBits(const CardSet::MaskT mask)
+{
+    return ((mask & CardSet::sSuitMask) != 0) |
+           (((mask & (CardSet::sSuitMask << 1)) != 0) << 1) |
+           (((mask & (CardSet::sSuitMask << 2)) != 0) << 2) |
+           (((mask & (CardSet::sSuitMask << 3)) != 0) << 3);
+}
+
+// spreads a 13-bit rank mask to one bit per rank nibble (bit 4r)
+constexpr CardSet::MaskT
+spreadRanks(const uint16_t ranks)
+{
+    CardSet::MaskT mask = 0;
+    for (uint16_t rank = 0; rank < CardSet::sNumRanks; ++rank) {
+        if (ranks & (1 << rank)) {
+            mask |= 1ULL << (rank * 4);
+        }
+    }
+    return mask;
+}
+
+// five-card sets are enumerated and classified this many at a time
+const uint16_t sBatchSize = 64;
+
+#ifdef PUSOYDOS_AVX2_KERNEL
+
+// combo types of four five-card masks, one per 64-bit lane (kUndef if none).
+// Mirrors classify() without tables: per-rank counts come from nibble
+// popcounts, straights are five consecutive rank nibbles (or one of the
+// two wrap-around straights) and flushes have every card in one suit.
+__attribute__((target("avx2"))) inline __m256i
+classifyTypes4(const __m256i m)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i suitMask = _mm256_set1_epi64x(CardSet::sSuitMask);
+
+    __m256i counts = _mm256_sub_epi64(m, _mm256_and_si256(_mm256_srli_epi64(m, 1),
+                                                          _mm256_set1_epi64x(0x5555555555555555ULL)));
+    const __m256i m3 = _mm256_set1_epi64x(0x3333333333333333ULL);
+    counts = _mm256_add_epi64(_mm256_and_si256(counts, m3),
+                              _mm256_and_si256(_mm256_srli_epi64(counts, 2), m3));
+    const __m256i twos = _mm256_and_si256(_mm256_srli_epi64(counts, 1), suitMask);
+    const __m256i threes = _mm256_and_si256(counts, twos);
+    const __m256i fours = _mm256_and_si256(_mm256_srli_epi64(counts, 2), suitMask);
+
+    // no rank held twice or more
+    const __m256i distinct = _mm256_cmpeq_epi64(_mm256_or_si256(twos, fours), zero);
+    // a triple plus a second rank held at least twice
+    const __m256i twoPairs = _mm256_and_si256(twos, _mm256_sub_epi64(twos, _mm256_set1_epi64x(1)));
+    const __m256i fullHouse = _mm256_xor_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi64(threes, zero), _mm256_cmpeq_epi64(twoPairs, zero)), ones);
+    const __m256i fourKind = _mm256_xor_si256(_mm256_cmpeq_epi64(fours, zero), ones);
+
+    // one bit per rank present, at the rank's lowest suit
+    __m256i ranks = _mm256_or_si256(_mm256_or_si256(m, _mm256_srli_epi64(m, 1)),
+                                    _mm256_or_si256(_mm256_srli_epi64(m, 2), _mm256_srli_epi64(m, 3)));
+    ranks = _mm256_and_si256(ranks, suitMask);
+    const __m256i low = _mm256_and_si256(ranks, _mm256_sub_epi64(zero, ranks));
+    const __m256i run = _mm256_or_si256(
+        _mm256_or_si256(low, _mm256_slli_epi64(low, 4)),
+        _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi64(low, 8), _mm256_slli_epi64(low, 12)),
+                        _mm256_slli_epi64(low, 16)));
+    __m256i straight = _mm256_or_si256(
+        _mm256_cmpeq_epi64(ranks, run),
+        _mm256_or_si256(_mm256_cmpeq_epi64(ranks, _mm256_set1_epi64x(spreadRanks(sAceLowStraight))),
+                        _mm256_cmpeq_epi64(ranks, _mm256_set1_epi64x(spreadRanks(sDeuceLowStraight)))));
+    straight = _mm256_and_si256(straight, distinct);
+
+    __m256i flush = zero;
+    for (uint16_t suit = 0; suit < CardSet::sNumSuits; ++suit) {
+        const __m256i suitCards = _mm256_and_si256(m, _mm256_slli_epi64(suitMask, suit));
+        flush = _mm256_or_si256(flush, _mm256_cmpeq_epi64(suitCards, m));
+    }
+    flush = _mm256_and_si256(flush, distinct);
+
+    __m256i types = _mm256_set1_epi64x(Combo::kUndef);
+    types = _mm256_blendv_epi8(types, _mm256_set1_epi64x(Combo::kFourKind), fourKind);
+    types = _mm256_blendv_epi8(types, _mm256_set1_epi64x(Combo::kFullHouse), fullHouse);
+    types = _mm256_blendv_epi8(types, _mm256_set1_epi64x(Combo::kFlush), flush);
+    types = _mm256_blendv_epi8(types, _mm256_set1_epi64x(Combo::kStraight), straight);
+    types = _mm256_blendv_epi8(types, _mm256_set1_epi64x(Combo::kStraightFlush),
+                               _mm256_and_si256(straight, flush));
+    return types;
+}
+
+__attribute__((target("avx2"))) void
+classifyTypesAvx2(const CardSet::MaskT* masks, const uint16_t count, uint8_t* types)
+{
+    uint64_t lanes[8];
+    uint16_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i* in = (const __m256i*)(masks + i);
+        _mm256_storeu_si256((__m256i*)lanes, classifyTypes4(_mm256_loadu_si256(in)));
+        _mm256_storeu_si256((__m256i*)(lanes + 4), classifyTypes4(_mm256_loadu_si256(in + 1)));
+        for (uint16_t k = 0; k < 8; ++k) {
+            types[i+k] = lanes[k];
+        }
+    }
+    for (; i < count; i += 4) {
+        // tail padded with empty sets, which classify as kUndef
+        uint64_t tail[4] = { 0, 0, 0, 0 };
+        uint16_t n = (count - i < 4) ? count - i : 4;
+        for (uint16_t k = 0; k < n; ++k) {
+            tail[k] = masks[i+k];
+        }
+        _mm256_storeu_si256((__m256i*)lanes, classifyTypes4(_mm256_loadu_si256((const __m256i*)tail)));
+        for (uint16_t k = 0; k < n; ++k) {
+            types[i+k] = lanes[k];
+        }
+    }
+}
+
+#endif
+
+} /* anonymous namespace */
+
+const uint16_t ComboClassifier::sMaxFiveCardSubsets;
+
+uint32_t
+ComboClassifier::_makeKey(const Combo::ComboT type, const uint32_t strength)
+{
+    return ((uint32_t)(type + 1) << 24) | strength;
+}
+
+uint32_t
+ComboClassifier::_getKeyOfType(const Combo::ComboT type, const CardSet& cards)
+{
+    switch (type) {
+      case Combo::kStraight:
+      case Combo::kStraightFlush:
+        {
+            uint16_t straightHigh = sRankTables.straightHigh[cards.getRankMask()];
+            return _makeKey(type, cards.getRankCards(straightHigh - 1).lowest());
+        }
+      case Combo::kFlush:
+        {
+            uint16_t flushSuit = sSingleSuit[getSuitBits(cards.getMask())];
+            return _makeKey(type, (sRankTables.digits[cards.getRankMask()] << 2) | (flushSuit - 1));
+        }
+      case Combo::kFullHouse:
+        {
+            const CardSet::MaskT counts = cards.getRankCounts();
+            return _makeKey(type, __builtin_ctzll(counts & (counts >> 1) & CardSet::sSuitMask) >> 2);
+        }
+      case Combo::kFourKind:
+        return _makeKey(type, __builtin_ctzll((cards.getRankCounts() >> 2) & CardSet::sSuitMask) >> 2);
+      default:
+        return 0;
+    }
+}
+
+ComboClassifier::Result
+ComboClassifier::classify(const CardSet& cards)
+{
+    Result result;
+    result.cards = cards;
+    result.type = Combo::kUndef;
+    result.key = 0;
+    if (cards.size() != Combo::sMaxComboSize) {
+        return result;
+    }
+
+    // per-rank counts in nibbles; a nibble of 2 has bit 1 set, of 3 bits 0
+    // and 1, of 4 bit 2, which gives 1, 3 and 6 same-rank pairs
+    const CardSet::MaskT counts = cards.getRankCounts();
+    const CardSet::MaskT twos = (counts >> 1) & CardSet::sSuitMask;
+    const CardSet::MaskT threes = counts & (counts >> 1) & CardSet::sSuitMask;
+    const CardSet::MaskT fours = (counts >> 2) & CardSet::sSuitMask;
+    uint16_t pairs = __builtin_popcountll(twos) + 2 * __builtin_popcountll(threes) +
+                     6 * __builtin_popcountll(fours);
+
+    switch (sShapeByPairs[pairs]) {
+      case kDistinctShape:
+        {
+            uint16_t ranks = cards.getRankMask();
+            uint16_t straightHigh = sRankTables.straightHigh[ranks];
+            uint16_t flushSuit = sSingleSuit[getSuitBits(cards.getMask())];
+            if (straightHigh != 0) {
+                // only one card of each rank in a straight
+                uint32_t highCard = cards.getRankCards(straightHigh - 1).lowest();
+                result.type = (flushSuit != 0) ? Combo::kStraightFlush : Combo::kStraight;
+                result.key = _makeKey(result.type, highCard);
+            }
+            else if (flushSuit != 0) {
+                result.type = Combo::kFlush;
+                result.key = _makeKey(result.type,
+                                      (sRankTables.digits[ranks] << 2) | (flushSuit - 1));
+            }
+        }
+        break;
+      case kFullHouseShape:
+        result.type = Combo::kFullHouse;
+        result.key = _makeKey(result.type, __builtin_ctzll(threes) >> 2);
+        break;
+      case kFourKindShape:
+        result.type = Combo::kFourKind;
+        result.key = _makeKey(result.type, __builtin_ctzll(fours) >> 2);
+        break;
+      default:
+        break;
+    }
+    return result;
+}
+
+uint32_t
+ComboClassifier::getKey(const Combo::ComboT type, const CardSet& cards)
+{
+    Result result = classify(cards);
+    if (result.type == type) {
+        return result.key;
+    }
+    if (result.type == Combo::kStraightFlush) {
+        if (type == Combo::kStraight) {
+            return _makeKey(type, result.key & 0xFFFFFF);
+        }
+        else if (type == Combo::kFlush) {
+            uint16_t suit = CardSet::getSuit(cards.lowest());
+            return _makeKey(type, (sRankTables.digits[cards.getRankMask()] << 2) | suit);
+        }
+    }
+    return 0;
+}
+
+void
+ComboClassifier::classifyBatch(const CardSet::MaskT* masks, const uint16_t count,
+                               Result* results)
+{
+#ifdef PUSOYDOS_AVX2_KERNEL
+    if (hasAvx2()) {
+        uint8_t types[sBatchSize];
+        for (uint16_t start = 0; start < count; start += sBatchSize) {
+            uint16_t n = (count - start < sBatchSize) ? count - start : sBatchSize;
+            classifyTypesAvx2(masks + start, n, types);
+            for (uint16_t i = 0; i < n; ++i) {
+                Result& result = results[start + i];
+                result.cards = CardSet(masks[start + i]);
+                result.type = (Combo::ComboT)types[i];
+                result.key = _getKeyOfType(result.type, result.cards);
+            }
+        }
+        return;
+    }
+#endif
+    for (uint16_t i = 0; i < count; ++i) {
+        results[i] = classify(CardSet(masks[i]));
+    }
+}
+
+uint16_t
+ComboClassifier::classifyAll(const CardSet& hand, Result* results,
+                             const uint16_t maxResults)
+{
+    uint8_t codes[CardSet::sNumCards];
+    uint16_t numCards = 0;
+    for (CardSet::MaskT m = hand.getMask(); m; m &= m - 1) {
+        codes[numCards++] = __builtin_ctzll(m);
+    }
+
+    CardSet::MaskT masks[sBatchSize];
+    uint16_t numMasks = 0;
+    uint16_t numResults = 0;
+    for (uint16_t a = 0; a < numCards; ++a) {
+        CardSet::MaskT ma = CardSet::getBit(codes[a]);
+        for (uint16_t b = a+1; b < numCards; ++b) {
+            CardSet::MaskT mb = ma | CardSet::getBit(codes[b]);
+            for (uint16_t c = b+1; c < numCards; ++c) {
+                CardSet::MaskT mc = mb | CardSet::getBit(codes[c]);
+                for (uint16_t d = c+1; d < numCards; ++d) {
+                    CardSet::MaskT md = mc | CardSet::getBit(codes[d]);
+                    for (uint16_t e = d+1; e < numCards; ++e) {
+                        masks[numMasks++] = md | CardSet::getBit(codes[e]);
+                        if (numMasks == sBatchSize) {
+                            if (!_addValid(masks, numMasks, results, numResults, maxResults)) {
+                                return numResults;
+                            }
+                            numMasks = 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    _addValid(masks, numMasks, results, numResults, maxResults);
+    return numResults;
+}
+
+bool
+ComboClassifier::_addValid(const CardSet::MaskT* masks, const uint16_t count,
+                           Result* results, uint16_t& numResults,
+                           const uint16_t maxResults)
+{
+    Result batch[sBatchSize];
+    classifyBatch(masks, count, batch);
+    for (uint16_t i = 0; i < count; ++i) {
+        if (batch[i].type == Combo::kUndef) {
+            continue;
+        }
+        if (numResults == maxResults) {
+            return false;
+        }
+        results[numResults++] = batch[i];
+    }
+    return true;
+}
+
+bool
+ComboClassifier::hasAvx2(void)
+{
+#ifdef PUSOYDOS_AVX2_KERNEL
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+} /* namespace pusoydos */
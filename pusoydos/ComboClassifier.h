@@ -0,0 +1,65 @@
+#ifndef _PUSOYDOS_COMBOCLASSIFIER_H_
+#define _PUSOYDOS_COMBOCLASSIFIER_H_
+
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+
+namespace pusoydos {
+
+// classifies five-card sets into their best pusoy dos combo type and
+// strength key (same format as Combo::getKey) using lookup tables
+// generated at compile time; never allocates
+class ComboClassifier
+{
+  public:
+    class Result
+    {
+      public:
+        CardSet       cards;
+        Combo::ComboT type;
+        uint32_t      key;
+    };
+
+    // best five-card combo formed by exactly five cards,
+    // type kUndef (key 0) if the cards form none
+    static Result classify(const CardSet& cards);
+
+    // key of the five cards played as given five-card type, 0 if the cards
+    // do not form that type (a straight flush also counts as straight/flush)
+    static uint32_t getKey(const Combo::ComboT type, const CardSet& cards);
+
+    // classifies count five-card sets (each mask must hold exactly five
+    // cards), results[i] as classify(masks[i]). Types are found eight sets
+    // at a time with AVX2 when the CPU has it, and keys are then computed
+    // only for the sets that form a combo; falls back to classify()
+    static void classifyBatch(const CardSet::MaskT* masks, const uint16_t count,
+                              Result* results);
+
+    // classifies every five-card subset of hand, writing the valid combos
+    // to results (at most maxResults); returns number written
+    static uint16_t classifyAll(const CardSet& hand, Result* results,
+                                const uint16_t maxResults);
+
+    // true if classifyBatch runs the AVX2 kernel on this CPU
+    static bool hasAvx2(void);
+
+    // C(13,5), enough for every five-card subset of a 13-card hand
+    static const uint16_t sMaxFiveCardSubsets = 1287;
+
+  private:
+    static uint32_t _makeKey(const Combo::ComboT type, const uint32_t strength);
+    // key of five cards known to form the given type
+    static uint32_t _getKeyOfType(const Combo::ComboT type, const CardSet& cards);
+    // classifies a batch of at most sBatchSize sets and appends the combos
+    // to results; false once results is full
+    static bool _addValid(const CardSet::MaskT* masks, const uint16_t count,
+                          Result* results, uint16_t& numResults,
+                          const uint16_t maxResults);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,160 @@
+#include <algorithm>
+
+#include "EndgameSolver.h"
+#include "MoveGenerator.h"
+#include "Zobrist.h"
+
+namespace pusoydos {
+
+namespace {
+
+// transposition table values
+const uint8_t sLoss = 1;
+const uint8_t sWin = 2;
+
+// plays that go out first, then the most cards, then the strongest
+bool
+shedsMore(const Combo& a, const Combo& b)
+{
+    if (a.getSize() != b.getSize()) {
+        return a.getSize() > b.getSize();
+    }
+    return a.getKey() > b.getKey();
+}
+
+} /* anonymous namespace */
+
+const uint16_t EndgameSolver::sMaxCards;
+const uint16_t EndgameSolver::sDefaultTableBits;
+const uint64_t EndgameSolver::sDefaultMaxNodes;
+const uint16_t EndgameSolver::sMaxPlyMoves = MoveGenerator::sMaxMoves + 1;
+
+EndgameSolver::EndgameSolver(const uint16_t tableBits)
+    : _ownTable(new TranspositionTable(tableBits)),
+      _table(_ownTable.get()),
+      _seat(0),
+      _nodes(0),
+      _maxNodes(0),
+      _aborted(false)
+{
+}
+
+EndgameSolver::EndgameSolver(TranspositionTable* table)
+    : _table(table),
+      _seat(0),
+      _nodes(0),
+      _maxNodes(0),
+      _aborted(false)
+{
+}
+
+void
+EndgameSolver::clear(void)
+{
+    _table->clear();
+}
+
+EndgameSolver::Result
+EndgameSolver::solve(const Position& pos, const uint64_t maxNodes)
+{
+    _seat = pos.toMove;
+    _nodes = 0;
+    _maxNodes = maxNodes;
+    _aborted = false;
+
+    Result result;
+    result.win = _search(pos, 0, &result.move);
+    result.solved = !_aborted;
+    result.nodes = _nodes;
+    if (_aborted) {
+        result.win = false;
+    }
+    return result;
+}
+
+bool
+EndgameSolver::_search(const Position& pos, const uint16_t ply, Combo* bestMove)
+{
+    if (pos.isTerminal()) {
+        return (pos.getWinner() == _seat);
+    }
+    if (++_nodes > _maxNodes) {
+        _aborted = true;
+        return false;
+    }
+
+    // values are relative to the root player
+    uint64_t key = pos.key ^ Zobrist::getObserverKey(_seat);
+    TranspositionTable::Entry entry;
+    bool found = _table->probe(key, entry);
+    if (found && bestMove == NULL) {
+        return (entry.value == sWin);
+    }
+
+    // the player to move at the root looks for one winning play, the
+    // others for one play that refutes it
+    uint64_t startNodes = _nodes;
+    bool maximizing = (pos.toMove == _seat);
+    bool value = !maximizing;
+    uint16_t best = 0;
+    uint16_t numMoves = _orderMoves(pos, ply, found ? &entry : NULL);
+    for (uint16_t i = 0; i < numMoves; ++i) {
+        Position next = pos;
+        const Combo& move = _moves[ply * sMaxPlyMoves + i];
+        if (move.getSize() == 0) {
+            next.pass();
+        }
+        else {
+            next.play(move);
+        }
+        bool win = _search(next, ply + 1, NULL);
+        if (_aborted) {
+            return false;
+        }
+        if (win == maximizing) {
+            best = i;
+            value = win;
+            break;
+        }
+    }
+
+    const Combo& move = _moves[ply * sMaxPlyMoves + best];
+    if (bestMove != NULL) {
+        // winning play, or the first one tried if none wins
+        *bestMove = move;
+    }
+    entry.value = value ? sWin : sLoss;
+    entry.work = TranspositionTable::getWork(_nodes - startNodes);
+    entry.moveType = move.getType();
+    entry.moveCards = move.getCardSet();
+    _table->store(key, entry);
+    return value;
+}
+
+uint16_t
+EndgameSolver::_orderMoves(const Position& pos, const uint16_t ply,
+                           const TranspositionTable::Entry* hint)
+{
+    if (_moves.size() < (uint64_t)(ply + 1) * sMaxPlyMoves) {
+        _moves.resize((uint64_t)(ply + 1) * sMaxPlyMoves);
+    }
+    Combo* moves = &_moves[ply * sMaxPlyMoves];
+    uint16_t numMoves = pos.generateMoves(moves, MoveGenerator::sMaxMoves);
+    std::sort(moves, moves + numMoves, shedsMore);
+    if (pos.canPass()) {
+        // passing is tried last
+        moves[numMoves++] = Combo();
+    }
+    if (hint != NULL) {
+        // best play of an earlier search of this position goes first
+        for (uint16_t i = 0; i < numMoves; ++i) {
+            if (hint->isMove(moves[i])) {
+                std::rotate(moves, moves + i, moves + i + 1);
+                break;
+            }
+        }
+    }
+    return numMoves;
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,77 @@
+#ifndef _PUSOYDOS_ENDGAMESOLVER_H_
+#define _PUSOYDOS_ENDGAMESOLVER_H_
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+// pusoydos
+#include "Combo.h"
+#include "Position.h"
+#include "TranspositionTable.h"
+
+namespace pusoydos {
+
+// exact solver for positions with every hand known. Search is paranoid:
+// the other players cooperate against the player to move, so a position is
+// a win only if that player can go out first whatever the others do, which
+// turns alpha-beta into a win/loss AND/OR search. Plays that shed the most
+// cards are tried first, and solved positions are kept in a transposition
+// table that may be shared by several solvers. Entries live until clear():
+// they are exact whatever game they came from, but a solve that hits the
+// node limit depends on what the table already holds, so owners that need
+// reproducible play clear it at every new game.
+class EndgameSolver
+{
+  public:
+    class Result
+    {
+      public:
+        // false if the node limit was hit before the position was solved
+        bool     solved;
+        // player to move wins against any play of the others
+        bool     win;
+        // winning play if win, otherwise the first play tried; pass if empty
+        Combo    move;
+        uint64_t nodes;
+    };
+
+    // tableBits: log2 of the number of transposition table entries
+    EndgameSolver(const uint16_t tableBits = sDefaultTableBits);
+    // searches with a table shared with other solvers, possibly running on
+    // other threads; table must outlive the solver
+    EndgameSolver(TranspositionTable* table);
+
+    Result solve(const Position& pos, const uint64_t maxNodes = sDefaultMaxNodes);
+
+    // forgets every solved position (of a shared table too)
+    void clear(void);
+
+    // positions with at most this many cards left are meant to be solved
+    static const uint16_t sMaxCards = 20;
+
+    static const uint16_t sDefaultTableBits = 16;
+    static const uint64_t sDefaultMaxNodes = 200000;
+
+  private:
+    std::unique_ptr<TranspositionTable> _ownTable;
+    TranspositionTable* _table;
+    // per-ply move lists, plies at sMaxPlyMoves offsets
+    std::vector<Combo> _moves;
+
+    uint8_t  _seat;
+    uint64_t _nodes;
+    uint64_t _maxNodes;
+    bool     _aborted;
+
+    bool _search(const Position& pos, const uint16_t ply, Combo* bestMove);
+    uint16_t _orderMoves(const Position& pos, const uint16_t ply,
+                         const TranspositionTable::Entry* hint);
+
+    // every play plus a pass
+    static const uint16_t sMaxPlyMoves;
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,307 @@
+#include <time.h>
+#include <math.h>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+#include "Game.h"
+#include "Evaluator.h"
+
+namespace pusoydos {
+
+static double
+monotonicSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+Evaluator::Evaluator(const std::string& candidate, const std::string& baseline,
+                     const uint16_t numPlayers, const uint16_t numCandidates,
+                     const uint64_t maxGames, const uint32_t seed,
+                     const uint16_t numThreads)
+    : _candidate(candidate),
+      _baseline(baseline),
+      _numPlayers(numPlayers),
+      _numCandidates(numCandidates),
+      _maxGames(maxGames),
+      _seed(seed),
+      _numThreads(numThreads),
+      _sprt(false),
+      _elo0(0.0),
+      _elo1(0.0),
+      _alpha(0.05),
+      _beta(0.05),
+      _numGames(0),
+      _wins(0),
+      _llr(0.0),
+      _verdict(kUndecided),
+      _nextGame(0),
+      _stopping(false),
+      _elapsed(0.0)
+{
+    if (_numThreads == 0) {
+        _numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (_candidate == "human" || _baseline == "human") {
+        throw std::invalid_argument("evaluation cannot seat human players");
+    }
+    if (_numCandidates == 0 || _numCandidates >= _numPlayers) {
+        throw std::invalid_argument("candidates must hold some but not all seats");
+    }
+    // all C(numPlayers, numCandidates) seat sets, not just the blocks of
+    // neighbouring seats: blocks never seat candidates apart
+    for (uint16_t seats = 0; seats < (1 << _numPlayers); ++seats) {
+        if (__builtin_popcount(seats) != _numCandidates) {
+            continue;
+        }
+        std::vector<std::string> lineup(_numPlayers, _baseline);
+        for (uint16_t i = 0; i < _numPlayers; ++i) {
+            if (seats & (1 << i)) {
+                lineup[i] = _candidate;
+            }
+        }
+        _seatSets.push_back(seats);
+        _lineups.push_back(lineup);
+    }
+    _seatSetGames.resize(_seatSets.size(), 0);
+    _seatSetWins.resize(_seatSets.size(), 0);
+}
+
+void
+Evaluator::setSprt(const double elo0, const double elo1,
+                   const double alpha, const double beta)
+{
+    if (elo1 <= elo0 || alpha <= 0.0 || alpha >= 1.0 || beta <= 0.0 || beta >= 1.0) {
+        throw std::invalid_argument("invalid sprt bounds");
+    }
+    _sprt = true;
+    _elo0 = elo0;
+    _elo1 = elo1;
+    _alpha = alpha;
+    _beta = beta;
+}
+
+void
+Evaluator::run(void)
+{
+    _pending.clear();
+    _numGames = 0;
+    _wins = 0;
+    std::fill(_seatSetGames.begin(), _seatSetGames.end(), 0);
+    std::fill(_seatSetWins.begin(), _seatSetWins.end(), 0);
+    _llr = 0.0;
+    _verdict = kUndecided;
+    _nextGame.store(0);
+    _stopping.store(false);
+
+    std::vector<std::exception_ptr> errors(_numThreads);
+    std::vector<std::thread> workers;
+    double start = monotonicSeconds();
+    for (uint16_t t = 0; t < _numThreads; ++t) {
+        workers.push_back(std::thread(&Evaluator::_runWorker, this, &errors[t]));
+    }
+    for (uint16_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    _elapsed = monotonicSeconds() - start;
+    for (uint16_t t = 0; t < _numThreads; ++t) {
+        if (errors[t]) {
+            std::rethrow_exception(errors[t]);
+        }
+    }
+}
+
+void
+Evaluator::_runWorker(std::exception_ptr* error)
+{
+    try {
+        // one game per seat set, created on its first use
+        std::vector<std::unique_ptr<Game> > games(_seatSets.size());
+        while (!_stopping.load()) {
+            uint64_t g = _nextGame.fetch_add(1);
+            if (g >= _maxGames) {
+                break;
+            }
+            size_t seatSet = g % _seatSets.size();
+            if (!games[seatSet]) {
+                games[seatSet].reset(new Game(_lineups[seatSet]));
+            }
+            // game g is deal g of the seed whichever worker plays it, and
+            // plays out the same: players keep nothing from earlier games
+            // (see CpuPlayer::reset)
+            games[seatSet]->setSeed(_seed, g);
+            uint16_t winner = games[seatSet]->simulateSet();
+            // seats by type, so a candidate can also be tested against itself
+            _addResult(g, (_seatSets[seatSet] >> winner) & 1);
+        }
+    }
+    catch (...) {
+        *error = std::current_exception();
+        _stopping.store(true);
+    }
+}
+
+void
+Evaluator::_addResult(const uint64_t game, const bool candidateWon)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_verdict != kUndecided) {
+        // sets still in flight when the test ended do not count
+        return;
+    }
+    _pending[game] = candidateWon;
+    double p0 = getScore(_elo0, _numPlayers, _numCandidates);
+    double p1 = getScore(_elo1, _numPlayers, _numCandidates);
+    std::unordered_map<uint64_t, bool>::iterator next;
+    while ((next = _pending.find(_numGames)) != _pending.end()) {
+        bool won = next->second;
+        _pending.erase(next);
+        size_t seatSet = _numGames % _seatSets.size();
+        ++_numGames;
+        ++_seatSetGames[seatSet];
+        if (won) {
+            ++_wins;
+            ++_seatSetWins[seatSet];
+        }
+        if (!_sprt) {
+            continue;
+        }
+        _llr += won ? log(p1 / p0) : log((1.0 - p1) / (1.0 - p0));
+        if (_llr <= log(_beta / (1.0 - _alpha))) {
+            _verdict = kAcceptH0;
+        }
+        else if (_llr >= log((1.0 - _beta) / _alpha)) {
+            _verdict = kAcceptH1;
+        }
+        if (_verdict != kUndecided) {
+            // every earlier game has counted, every later one never will
+            _pending.clear();
+            _stopping.store(true);
+            return;
+        }
+    }
+}
+
+uint64_t
+Evaluator::getNumGames(void) const
+{
+    return _numGames;
+}
+
+uint64_t
+Evaluator::getCandidateWins(void) const
+{
+    return _wins;
+}
+
+double
+Evaluator::getScore(void) const
+{
+    return (_numGames > 0) ? (double)_wins / _numGames : 0.0;
+}
+
+double
+Evaluator::getElo(void) const
+{
+    return getElo(getScore(), _numPlayers, _numCandidates);
+}
+
+void
+Evaluator::getEloInterval(double& low, double& high) const
+{
+    double p = getScore();
+    double margin = (_numGames > 0) ? 1.96 * sqrt(p * (1.0 - p) / _numGames) : 1.0;
+    low = getElo(p - margin, _numPlayers, _numCandidates);
+    high = getElo(p + margin, _numPlayers, _numCandidates);
+}
+
+double
+Evaluator::getLlr(void) const
+{
+    return _llr;
+}
+
+Evaluator::VerdictT
+Evaluator::getVerdict(void) const
+{
+    return _verdict;
+}
+
+double
+Evaluator::getElapsedSeconds(void) const
+{
+    return _elapsed;
+}
+
+double
+Evaluator::getElo(const double score, const uint16_t numPlayers,
+                  const uint16_t numCandidates)
+{
+    // keeps scores of 0 and 1 finite
+    double p = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    double k = numCandidates;
+    double rest = numPlayers - numCandidates;
+    return 400.0 * log10(p * rest / (k * (1.0 - p)));
+}
+
+double
+Evaluator::getScore(const double elo, const uint16_t numPlayers,
+                    const uint16_t numCandidates)
+{
+    double strength = pow(10.0, elo / 400.0);
+    double k = numCandidates;
+    double rest = numPlayers - numCandidates;
+    return k * strength / (k * strength + rest);
+}
+
+void
+Evaluator::printSummary(std::ostream& os) const
+{
+    double low;
+    double high;
+    getEloInterval(low, high);
+    os << "candidate: " << _candidate << " (" << _numCandidates << " of " << _numPlayers << " seats)"
+       << "  baseline: " << _baseline << "\n";
+    os << "games: " << _numGames
+       << "  candidate wins: " << _wins
+       << "  score: " << std::fixed << std::setprecision(4) << getScore()
+       << " (even: " << getScore(0.0, _numPlayers, _numCandidates) << ")"
+       << "  threads: " << _numThreads
+       << "  time: " << std::setprecision(3) << _elapsed << "s\n";
+    os << "elo: " << std::showpos << std::setprecision(1) << getElo()
+       << "  95% interval: [" << low << ", " << high << "]" << std::noshowpos << "\n";
+    for (size_t s = 0; s < _seatSets.size(); ++s) {
+        double score = (_seatSetGames[s] > 0) ? (double)_seatSetWins[s] / _seatSetGames[s] : 0.0;
+        std::string seats;
+        for (uint16_t i = 0; i < _numPlayers; ++i) {
+            if (_seatSets[s] & (1 << i)) {
+                seats += seats.empty() ? "" : ",";
+                seats += std::to_string(i + 1);
+            }
+        }
+        os << "candidates at seats " << std::left << std::setw(2 * _numPlayers - 1) << seats << std::right
+           << "  games: " << std::setw(8) << _seatSetGames[s]
+           << "  score: " << std::setprecision(4) << score << "\n";
+    }
+    if (_sprt) {
+        os << "sprt elo0: " << std::setprecision(1) << _elo0 << "  elo1: " << _elo1
+           << "  alpha: " << std::setprecision(3) << _alpha << "  beta: " << _beta
+           << "  llr: " << _llr
+           << " [" << log(_beta / (1.0 - _alpha)) << ", " << log((1.0 - _beta) / _alpha) << "]  ";
+        if (_verdict == kAcceptH1) {
+            os << "H1 accepted\n";
+        }
+        else if (_verdict == kAcceptH0) {
+            os << "H0 accepted\n";
+        }
+        else {
+            os << "undecided\n";
+        }
+    }
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,110 @@
+#ifndef _PUSOYDOS_EVALUATOR_H_
+#define _PUSOYDOS_EVALUATOR_H_
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <ostream>
+#include <exception>
+#include <stdint.h>
+
+namespace pusoydos {
+
+// strength test of a candidate player type against a baseline. Plays
+// headless sets in parallel in which numCandidates of the seats are
+// candidates, the games cycling through every choice of candidate seats so
+// neither side keeps a seat or an order of play around the table (two
+// candidates of four sit side by side as well as across the table), and
+// rates the share of sets the candidates win as an Elo difference. Ratings
+// follow Bradley-Terry: a seat wins in proportion to its strength, so with
+// k candidate seats out of n a candidate of equal strength wins k/n of the
+// sets. Optionally a sequential probability ratio
+// test of elo0 against elo1 stops the run as soon as either is accepted.
+// Results count in game order whichever thread finishes first, so a run
+// reports the same games, and the same verdict, for any number of threads.
+class Evaluator
+{
+  public:
+    typedef enum {
+        kUndecided = 0,
+        kAcceptH0  = 1,  // candidate is not better than elo0
+        kAcceptH1  = 2   // candidate is at least elo1 better
+    } VerdictT;
+
+    // player types as for Simulator lineups; numThreads of 0 uses all
+    // hardware threads. Plays games 0 to maxGames - 1 of seed at most.
+    Evaluator(const std::string& candidate, const std::string& baseline,
+              const uint16_t numPlayers, const uint16_t numCandidates,
+              const uint64_t maxGames, const uint32_t seed,
+              const uint16_t numThreads = 0);
+
+    // stops once the log-likelihood ratio of elo1 against elo0 leaves
+    // [log(beta / (1 - alpha)), log((1 - beta) / alpha)]
+    void setSprt(const double elo0, const double elo1,
+                 const double alpha = 0.05, const double beta = 0.05);
+
+    void run(void);
+
+    uint64_t getNumGames(void) const;
+    uint64_t getCandidateWins(void) const;
+    // share of the sets won by a candidate seat
+    double getScore(void) const;
+    double getElo(void) const;
+    // 95% confidence interval of the Elo difference
+    void getEloInterval(double& low, double& high) const;
+    double getLlr(void) const;
+    VerdictT getVerdict(void) const;
+    double getElapsedSeconds(void) const;
+
+    void printSummary(std::ostream& os) const;
+
+    // Elo difference of the candidates for a score with numCandidates of
+    // numPlayers seats, and back
+    static double getElo(const double score, const uint16_t numPlayers,
+                         const uint16_t numCandidates);
+    static double getScore(const double elo, const uint16_t numPlayers,
+                           const uint16_t numCandidates);
+
+  private:
+    std::string _candidate;
+    std::string _baseline;
+    uint16_t  _numPlayers;
+    uint16_t  _numCandidates;
+    uint64_t  _maxGames;
+    uint32_t  _seed;
+    uint16_t  _numThreads;
+    // candidate seats of each seat set, one bit per seat, and its lineup.
+    // Game g plays seat set g % _seatSets.size()
+    std::vector<uint16_t> _seatSets;
+    std::vector<std::vector<std::string> > _lineups;
+
+    bool      _sprt;
+    double    _elo0;
+    double    _elo1;
+    double    _alpha;
+    double    _beta;
+
+    // results, guarded by _mutex. Counted are games 0 to _numGames - 1,
+    // the ones finished ahead of an earlier game wait in _pending
+    std::mutex _mutex;
+    std::unordered_map<uint64_t, bool> _pending;
+    uint64_t  _numGames;
+    uint64_t  _wins;
+    std::vector<uint64_t> _seatSetGames;
+    std::vector<uint64_t> _seatSetWins;
+    double    _llr;
+    VerdictT  _verdict;
+
+    std::atomic<uint64_t> _nextGame;
+    std::atomic<bool> _stopping;
+    double    _elapsed;
+
+    void _runWorker(std::exception_ptr* error);
+    void _addResult(const uint64_t game, const bool candidateWon);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -1,7 +1,9 @@
 #include <sstream>
+#include <algorithm>
 #include <time.h>
 #include <iomanip>
 #include <math.h>
+#include <stdexcept>
 
 #include <iostream>
 
@@ -10,48 +12,149 @@
 
 // hearts
 #include "Game.h"
+#include "MctsPlayer.h"
+#include "MoveGenerator.h"
+#include "Random.h"
+#include "Stats.h"
 
 namespace pusoydos {
 
+namespace {
+
+// the unshuffled deck, every card code in order
+class DeckCodes
+{
+  public:
+    uint8_t codes[CardSet::sNumCards];
+};
+
+constexpr DeckCodes
+makeDeckCodes(void)
+{
+    DeckCodes deck{};
+    for (uint16_t i = 0; i < CardSet::sNumCards; ++i) {
+        deck.codes[i] = i;
+    }
+    return deck;
+}
+
+constexpr DeckCodes sDeck = makeDeckCodes();
+
+// the deck splits evenly
+bool
+isValidNumPlayers(const uint16_t numPlayers)
+{
+    return (numPlayers > 0 && numPlayers <= GameState::sMaxPlayers &&
+            CardSet::sNumCards % numPlayers == 0);
+}
+
+// attaches a sink to a game for the lifetime of the scope
+class SinkScope
+{
+  public:
+    SinkScope(Game& game, GameEventSink* sink)
+        : _game(game),
+          _saved(game.getEventSink())
+    {
+        _game.setEventSink(sink);
+    }
+
+    ~SinkScope(void)
+    {
+        _game.setEventSink(_saved);
+    }
+
+  private:
+    Game&          _game;
+    GameEventSink* _saved;
+};
+
+} /* anonymous namespace */
+
 const uint16_t Game::sDefaultNumPlayers = 4;
 const uint16_t Game::sDefaultScreenHeight = 64;
 
 Game::Game(const uint16_t screenHeight)
-    : _deck(52),
+    : _rules(Rules::standard()),
       _gameState(new GameState()),
       _numPlayers(sDefaultNumPlayers),
       _players(sDefaultNumPlayers),
       _screenHeight(screenHeight),
-      _numSets(0)
+      _numSets(0),
+      _setWinner(0),
+      _startingSeat(0),
+      _toMove(0),
+      _roundOpen(false),
+      _interactive(true),
+      _seed(time(NULL)),
+      _nextDeal(0),
+      _recordWriter(NULL),
+      _sink(GameEventSink::null())
 {
     _setupSuits();
     _setupPlayers();
 }
 
 Game::Game(const uint16_t numPlayers, const uint16_t screenHeight)
-    : _deck(52),
+    : _rules(Rules::standard()),
       _gameState(new GameState()),
       _numPlayers(numPlayers),
       _players(numPlayers),
       _screenHeight(screenHeight),
-      _numSets(0)
+      _numSets(0),
+      _setWinner(0),
+      _startingSeat(0),
+      _toMove(0),
+      _roundOpen(false),
+      _interactive(true),
+      _seed(time(NULL)),
+      _nextDeal(0),
+      _recordWriter(NULL),
+      _sink(GameEventSink::null())
 {
     _setupSuits();
     _setupPlayers();
 }
 
+Game::Game(const std::vector<std::string>& lineup, const uint16_t screenHeight)
+    : _rules(Rules::standard()),
+      _gameState(new GameState()),
+      _numPlayers(lineup.size()),
+      _players(lineup.size()),
+      _screenHeight(screenHeight),
+      _numSets(0),
+      _setWinner(0),
+      _startingSeat(0),
+      _toMove(0),
+      _roundOpen(false),
+      _interactive(false),
+      _seed(0),
+      _nextDeal(0),
+      _recordWriter(NULL),
+      _sink(GameEventSink::null())
+{
+    if (!isValidNumPlayers(lineup.size())) {
+        throw std::invalid_argument("invalid number of players");
+    }
+    _setupSuits();
+    _setupPlayers(lineup);
+}
+
 void
 Game::_setupSuits(void)
 {
-    Card::setSuitRank(Card::Clubs, kClubs);
-    Card::setSuitRank(Card::Spades, kSpades);
-    Card::setSuitRank(Card::Hearts, kHearts);
-    Card::setSuitRank(Card::Diamonds, kDiamonds);
+    _rules.setSuitRank(Card::Clubs, kClubs);
+    _rules.setSuitRank(Card::Spades, kSpades);
+    _rules.setSuitRank(Card::Hearts, kHearts);
+    _rules.setSuitRank(Card::Diamonds, kDiamonds);
 }
 
 void
 Game::_setupPlayers(void)
 {
+    if (!isValidNumPlayers(_numPlayers)) {
+        throw std::invalid_argument("invalid number of players");
+    }
     for (uint16_t i = 0; i < _numPlayers; ++i) {
         std::ostringstream oss;
         oss << i+1;
@@ -62,6 +165,33 @@ Game::_setupPlayers(void)
         else {
             _players[i] = new CpuPlayer("player" + oss.str());
         }
+        _players[i]->setRules(&_rules);
+        _players[i]->setSeat(i);
+        _scores.insert(ScoreMapT::value_type(_players[i]->getName(), 0));
+    }
+}
+
+void
+Game::_setupPlayers(const std::vector<std::string>& lineup)
+{
+    _humanPlayer = _numPlayers;
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        std::ostringstream oss;
+        oss << i+1;
+        _players[i] = Player::createPlayer(lineup[i], "player" + oss.str());
+        // the move buffers hold every play of a hand of at most
+        // MoveGenerator::sMaxHandSize cards only
+        if (_players[i]->listsPlays() &&
+            CardSet::sNumCards / _numPlayers > MoveGenerator::sMaxHandSize) {
+            throw std::invalid_argument("player type " + lineup[i] +
+                                        " needs hands of at most 13 cards");
+        }
+        if (lineup[i] == "human" && _humanPlayer == _numPlayers) {
+            _humanPlayer = i;
+            _interactive = true;
+        }
+        _players[i]->setRules(&_rules);
+        _players[i]->setSeat(i);
         _scores.insert(ScoreMapT::value_type(_players[i]->getName(), 0));
     }
 }
@@ -80,41 +210,79 @@ Game::~Game(void)
 }
 
 void
-Game::_createDeck(void)
-{
-    const SuitList& suits = Card::getSuitList();
-    const FaceList& faces = Card::getFaceList();
-    for (SuitList::const_iterator suitIt = suits.begin();
-         suitIt != suits.end(); ++suitIt) {
-
-        // number cards
-        for (uint16_t i = 2; i < 11; ++i) {
-            // 2s are highest-value cards
-            uint16_t value = (i == 2) ? 15 : i;
-            CardPtr numberCard(new Card(i, suitIt->first, value));
-            _deck.insertCard(numberCard);
-        }
+Game::setSeed(const uint64_t seed, const uint64_t firstDeal)
+{
+    _seed = seed;
+    _nextDeal = firstDeal;
+}
 
-        // face cards
-        for (FaceList::const_iterator faceIt = faces.begin();
-             faceIt != faces.end(); ++faceIt) {
-            CardPtr faceCard(new Card(faceIt->first, suitIt->first, faceIt->second));
-            _deck.insertCard(faceCard);
-        }
-    }
+void
+Game::setRecordWriter(GameRecordWriter* writer)
+{
+    _recordWriter = writer;
+}
+
+void
+Game::setEventSink(GameEventSink* sink)
+{
+    _sink = sink ? sink : GameEventSink::null();
+}
+
+GameEventSink*
+Game::getEventSink(void) const
+{
+    return _sink;
 }
 
 void
 Game::deal(void)
 {
-    _deck.reset();
-    _createDeck();
-    _deck.shuffle(10000 * (1+_numSets));
-    uint16_t deckSize = _deck.getDeckSize();
-    uint16_t numCardsPerPlayer = deckSize / _numPlayers;
-    for (uint16_t nCard = 0; nCard < numCardsPerPlayer; ++nCard) {
-        for (uint16_t i = 0; i < _numPlayers && _deck.getDeckSize() > 0; ++i) {
-            _players[i]->dealCard(_deck.pullFromTop());
+    deal(_seed, _nextDeal++);
+}
+
+void
+Game::deal(const uint64_t seed, const uint64_t index)
+{
+    PUSOYDOS_STATS_TIME(Stats::kDealTime);
+    PUSOYDOS_STATS_COUNT(Stats::kDeals);
+    CardSet hands[GameState::sMaxPlayers];
+    dealHands(seed, index, _numPlayers, hands);
+    uint16_t numCardsPerPlayer = hands[0].size();
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        // a new game, recycles the player's game arena
+        _players[i]->reset();
+        _players[i]->setHand(hands[i]);
+        _players[i]->seedRandom(seed, index);
+    }
+    if (_recordWriter) {
+        _record.begin(seed, index, _numPlayers, hands);
+    }
+    _sink->onDeal(index, hands, _numPlayers);
+    _gameState->played.clear();
+    _gameState->numPlayers = _numPlayers;
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        _gameState->cardsLeft[i] = numCardsPerPlayer;
+    }
+}
+
+void
+Game::dealHands(const uint64_t seed, const uint64_t index,
+                const uint16_t numPlayers, CardSet* hands)
+{
+    // one Fisher-Yates pass over the card codes, then consecutive runs of
+    // the shuffled deck become the hands
+    uint8_t codes[CardSet::sNumCards];
+    std::copy(sDeck.codes, sDeck.codes + CardSet::sNumCards, codes);
+    RandomStream rng(seed, index, RandomStream::sDealStream);
+    for (uint16_t i = CardSet::sNumCards - 1; i > 0; --i) {
+        std::swap(codes[i], codes[rng.below(i + 1)]);
+    }
+
+    uint16_t numCardsPerPlayer = CardSet::sNumCards / numPlayers;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        hands[i].clear();
+        for (uint16_t k = 0; k < numCardsPerPlayer; ++k) {
+            hands[i].add(codes[i * numCardsPerPlayer + k]);
         }
     }
 }
@@ -126,93 +294,192 @@ Game::findStartingCard(void)
         if (_players[i]->hasCard((uint16_t)3, Card::Clubs)) {
             _gameState->leadPlayer = i;
             _gameState->firstCombo = true;
+            _startingSeat = i;
             break;
         }
     }
 }
 
 bool
-Game::playRound(std::ostream& os)
+Game::playRound(void)
 {
-    _gameState->combo.resetAll();
+    PUSOYDOS_STATS_TIME(Stats::kRoundTime);
+    TurnT turn;
+    do {
+        turn = playTurn();
+    }
+    while (turn == kNextTurn);
+    return (turn == kRoundOver);
+}
 
-    for (uint16_t i = 0; i < _numPlayers; ++i) {
-        _players[i]->printHand(os);
-        os << "\n";
+void
+Game::beginSet(void)
+{
+    deal();
+    findStartingCard();
+    _roundOpen = false;
+}
+
+Game::TurnT
+Game::playTurn(void)
+{
+    Combo move;
+    Combo decided;
+    std::exception_ptr failed;
+    if (!requestMove(move, [&decided, &failed](const Combo& m, const std::exception_ptr& error) {
+            decided = m;
+            failed = error;
+        })) {
+        _players[getToMove()]->waitForMove();
+        if (failed) {
+            std::rethrow_exception(failed);
+        }
+        move = decided;
     }
+    return playMove(move);
+}
 
-    uint16_t playerIdx = _gameState->leadPlayer;
-    os << "Starting round, leader: " << _players[playerIdx]->getName() << "\n\n";
-    std::string cardPileString = "";
-    do {
-        std::ostringstream oss;
-        if (playerIdx == _humanPlayer) {
-            os << cardPileString;
+bool
+Game::requestMove(Combo& move, const Player::ResumeFn& resume)
+{
+    if (!_roundOpen) {
+        PUSOYDOS_STATS_COUNT(Stats::kRounds);
+        _gameState->combo.resetAll();
+        _toMove = _gameState->leadPlayer;
+        _roundOpen = true;
+        _sink->onRoundStart(_toMove);
+    }
+    PUSOYDOS_STATS_COUNT(Stats::kTurns);
+    _sink->onTurn(_toMove);
+    PUSOYDOS_STATS_TIME(Stats::kDecisionTime);
+    return _players[_toMove]->requestMove(_gameState, move, resume);
+}
+
+Game::TurnT
+Game::playMove(const Combo& move)
+{
+    uint16_t playerIdx = _toMove;
+    if (playerIdx == _gameState->leadPlayer) {
+        // lead combo
+        _gameState->combo = move;
+        PUSOYDOS_STATS_COMBO(_gameState->combo.getType());
+        _gameState->played.add(_gameState->combo.getCardSet());
+        if (_recordWriter) {
+            _record.addTurn(playerIdx, _gameState->combo);
         }
-        if (playerIdx == _gameState->leadPlayer) {
-            // lead combo
-            _gameState->combo = _players[playerIdx]->playLeadCombo(_gameState);
-            if (_gameState->firstCombo) {
-                _gameState->firstCombo = false;
-            }
-            _gameState->combo.printToStream(oss);
-            cardPileString += std::string(oss.str());
+        if (_gameState->firstCombo) {
+            _gameState->firstCombo = false;
         }
-        else {
-            // non-lead players can pass or beat the current combo
-            Combo followCombo(_players[playerIdx]->getName());
-            if (_players[playerIdx]->playFollowCombo(_gameState, followCombo)) {
-                // player beat current combo, so lead changes
-                _gameState->combo = followCombo;
-                _gameState->leadPlayer = playerIdx;
-                _gameState->combo.printToStream(oss);
-                cardPileString += std::string(oss.str());
-            }
+        _sink->onLead(playerIdx, _gameState->combo);
+    }
+    else if (move.getSize() > 0) {
+        // player beat current combo, so lead changes
+        PUSOYDOS_STATS_COMBO(move.getType());
+        if (_recordWriter) {
+            _record.addTurn(playerIdx, move);
         }
-        if (playerIdx == _humanPlayer) {
-            os << cardPileString;
-            _promptForEnter();
-            Util::clearScreen(os, _screenHeight);
+        _gameState->combo = move;
+        _gameState->leadPlayer = playerIdx;
+        _gameState->played.add(move.getCardSet());
+        _sink->onFollow(playerIdx, move);
+    }
+    else {
+        PUSOYDOS_STATS_COUNT(Stats::kPasses);
+        if (_recordWriter) {
+            _record.addTurn(playerIdx, Combo());
         }
-        if (_players[playerIdx]->cardsLeft() == 0) {
-            // player that ran out of cards wins
-            os << _players[playerIdx]->getName() << " WINS!\n";
-            scoreGame(_players[playerIdx]->getName(), _gameState->combo);
-            return false;
+        _sink->onPass(playerIdx);
+    }
+    _gameState->cardsLeft[playerIdx] = _players[playerIdx]->cardsLeft();
+    if (_players[playerIdx]->cardsLeft() == 0) {
+        // player that ran out of cards wins
+        uint16_t points = getSetPoints(_gameState->combo);
+        _sink->onSetWon(playerIdx, points);
+        scoreGame(_players[playerIdx]->getName(), _gameState->combo);
+        _setWinner = playerIdx;
+        _roundOpen = false;
+        PUSOYDOS_STATS_COUNT(Stats::kSets);
+        if (_recordWriter) {
+            _record.finish(playerIdx, points);
+            _recordWriter->append(_record);
         }
-        playerIdx = (playerIdx == _players.size()-1) ? 0 : playerIdx+1;
+        return kSetOver;
+    }
+    _toMove = (playerIdx == _players.size()-1) ? 0 : playerIdx+1;
+    if (_toMove != _gameState->leadPlayer) {
+        return kNextTurn;
     }
-    while (playerIdx != _gameState->leadPlayer);
+    _roundOpen = false;
+    _sink->onRoundWon(_gameState->leadPlayer);
+    return kRoundOver;
+}
 
-    os << "\nAll other players have passed. "
-       << _players[_gameState->leadPlayer]->getName()
-       << " wins the round.\n\n";
-    _promptForEnter();
-    return true;
+uint16_t
+Game::getToMove(void) const
+{
+    return _roundOpen ? _toMove : _gameState->leadPlayer;
+}
+
+const GameState&
+Game::getState(void) const
+{
+    return *_gameState;
+}
+
+uint16_t
+Game::getSetWinner(void) const
+{
+    return _setWinner;
+}
+
+uint16_t
+Game::getStartingSeat(void) const
+{
+    return _startingSeat;
 }
 
 void
-Game::_promptForEnter(void)
+Game::setEndgameSolver(EndgameSolver* solver)
 {
-    std::string enter;
-    printf("\n\n<Press Enter>");
-    std::cin.ignore(10000,'\n');
-    std::getline( std::cin, enter );
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        CpuPlayer* cpu = dynamic_cast<CpuPlayer*>(_players[i]);
+        if (cpu) {
+            cpu->setEndgameSolver(solver);
+        }
+    }
+}
+
+void
+Game::setDecisionPool(ThreadPool* pool)
+{
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        CpuPlayer* cpu = dynamic_cast<CpuPlayer*>(_players[i]);
+        if (cpu) {
+            cpu->setDecisionPool(pool);
+        }
+        MctsPlayer* mcts = dynamic_cast<MctsPlayer*>(_players[i]);
+        if (mcts) {
+            mcts->setSearchPool(pool);
+        }
+    }
 }
 
 void
 Game::scoreGame(const std::string& name, const Combo& finalCombo)
+{
+    _scores[name] += getSetPoints(finalCombo);
+}
+
+uint16_t
+Game::getSetPoints(const Combo& finalCombo)
 {
     // if last combo included a deuce, points (2^[#deuces])
     // otherwise just 1 point
     uint16_t numTwos = finalCombo.hasNumOfCard((uint16_t)2);
     if (numTwos > 0) {
-        _scores[name] += pow(2, numTwos);
-    }
-    else {
-        _scores[name] += 1;
+        return pow(2, numTwos);
     }
-    return;
+    return 1;
 }
 
 bool
@@ -242,37 +509,90 @@ Game::determineWinner(const uint16_t maxScore)
 void
 Game::playSet(std::ostream& os)
 {
-    deal();
-    findStartingCard();
+    TextEventSink text(*this, os, _humanPlayer, _screenHeight);
+    SinkScope scope(*this, &text);
+    _playSet(os);
+}
+
+void
+Game::_playSet(std::ostream& os)
+{
+    beginSet();
     Util::clearScreen(os, _screenHeight);
     do {
         Util::clearScreen(os, _screenHeight);
         os << "================================== NEW ROUND ===================================\n\n";
     }
-    while (playRound(os));
+    while (playRound());
     ++_numSets;
 
     for (uint16_t i = 0; i < _numPlayers; ++i) {
         _players[i]->reset();
     }
     printScoreTable(os, _scores);
-    _promptForEnter();
+    TextEventSink::promptForEnter();
+}
+
+uint16_t
+Game::simulateSet(void)
+{
+    if (_interactive) {
+        throw std::runtime_error("cannot simulate set with human player");
+    }
+    beginSet();
+    while (playRound());
+    ++_numSets;
+
+    for (uint16_t i = 0; i < _numPlayers; ++i) {
+        _players[i]->reset();
+    }
+    return _setWinner;
+}
+
+bool
+Game::isInteractive(void) const
+{
+    return _interactive;
+}
+
+uint16_t
+Game::getNumPlayers(void) const
+{
+    return _numPlayers;
+}
+
+const Player *
+Game::getPlayer(const uint16_t seat) const
+{
+    return _players.at(seat);
+}
+
+Player *
+Game::getPlayer(const uint16_t seat)
+{
+    return _players.at(seat);
+}
+
+const Rules&
+Game::getRules(void) const
+{
+    return _rules;
 }
 
 void
 Game::playGame(std::ostream& os)
 {
+    TextEventSink text(*this, os, _humanPlayer, _screenHeight);
+    SinkScope scope(*this, &text);
     Util::clearScreen(os, _screenHeight);
     while (!maxScoreReached(3)) {
         os << "================================================================================\n"
            << "================================== NEW SET =====================================\n"
            << "================================================================================\n\n";
-        playSet(os);
+        _playSet(os);
         os << "GAME SCORE:\n";
     }
-    os << "=========== GAME OVER ============\n";
-    os << "WINNER: " << std::right << determineWinner(3)->getName() << " !!!\n\n";
-    os << "==================================\n";
+    _sink->onGameWon(determineWinner(3)->getSeat());
 }
 
 void
@@ -3,13 +3,12 @@
 
 #include <vector>
 
-// game
-#include "Deck.h"
-
 // pusoydos
 #include "Combo.h"
 #include "Player.h"
 #include "GameState.h"
+#include "GameRecord.h"
+#include "GameEventSink.h"
 
 using namespace game;
 
@@ -24,15 +23,85 @@ class Game
   public:
     Game(const uint16_t screenHeight = sDefaultScreenHeight);
     Game(const uint16_t numPlayers, const uint16_t screenHeight = sDefaultScreenHeight);
+    // one player type per seat (see Player::createPlayer), e.g. "human", "cpu";
+    // seats that list their plays (see Player::listsPlays) need hands of at
+    // most MoveGenerator::sMaxHandSize cards, so four seats
+    Game(const std::vector<std::string>& lineup, const uint16_t screenHeight = sDefaultScreenHeight);
 
     ~Game(void);
 
+    // deals the next deal of the seeded sequence (see setSeed)
     void deal(void);
+    // deals game number index of the sequence for seed and seeds the
+    // players' random streams for that game; the same pair always gives
+    // the same hands
+    void deal(const uint64_t seed, const uint64_t index);
+
+    // hands of deal index for seed, without dealing them to any player
+    static void dealHands(const uint64_t seed, const uint64_t index,
+                          const uint16_t numPlayers, CardSet* hands);
+
+    // following deals are games firstDeal, firstDeal+1, ... for seed
+    void setSeed(const uint64_t seed, const uint64_t firstDeal = 0);
 
-    bool playRound(std::ostream& os);
+    // appends a record of every finished set to writer (not owned, NULL
+    // to stop recording)
+    void setRecordWriter(GameRecordWriter* writer);
+
+    // sink that receives the events of every following round (not owned,
+    // NULL for none)
+    void setEventSink(GameEventSink* sink);
+    GameEventSink* getEventSink(void) const;
+
+    typedef enum {
+        kNextTurn  = 0,  // the round goes on with getToMove()
+        kRoundOver = 1,  // everyone else passed, the last player leads next
+        kSetOver   = 2   // the player ran out of cards (see getSetWinner)
+    } TurnT;
+
+    // plays one round, reporting it to the event sink; false once a player
+    // has run out of cards
+    bool playRound(void);
+
+    // step-wise play for callers that cannot wait inside a player, e.g. a
+    // table server waiting on a client (see Table): beginSet deals the next
+    // deal and finds the leader, playTurn plays the turn of getToMove(),
+    // waiting for its player if the decision is pending
+    void beginSet(void);
+    TurnT playTurn(void);
+    uint16_t getToMove(void) const;
+
+    // the two halves of playTurn for callers that never wait: requestMove
+    // asks the player of getToMove() for its move (see Player::requestMove)
+    // and is true if move is set at once; otherwise the player calls
+    // resume later, and the game must not be touched until the move is
+    // played with playMove
+    bool requestMove(Combo& move, const Player::ResumeFn& resume);
+    TurnT playMove(const Combo& move);
+    const GameState& getState(void) const;
+    uint16_t getSetWinner(void) const;
+    // seat that held the 3 of clubs and led the current or last set
+    uint16_t getStartingSeat(void) const;
+
+    // endgame solver of every cpu seat (see CpuPlayer::setEndgameSolver)
+    void setEndgameSolver(EndgameSolver* solver);
+    // decision pool of every cpu seat and search pool of every ismcts seat
+    // (see CpuPlayer::setDecisionPool, MctsPlayer::setSearchPool)
+    void setDecisionPool(ThreadPool* pool);
+    // play on the console (see TextEventSink)
     void playSet(std::ostream& os);
     void playGame(std::ostream& os);
 
+    // plays one set (deal until a player runs out of cards) without any
+    // output or prompts, returns seat of winner; requires all-cpu lineup
+    uint16_t simulateSet(void);
+
+    bool isInteractive(void) const;
+    uint16_t getNumPlayers(void) const;
+    const Player * getPlayer(const uint16_t seat) const;
+    Player * getPlayer(const uint16_t seat);
+    const Rules& getRules(void) const;
+
     Player * determineWinner(const uint16_t maxScore);
     bool maxScoreReached(const uint16_t maxScore);
 
@@ -50,12 +119,15 @@ class Game
     static const uint16_t sDefaultNumPlayers;
     static const uint16_t sDefaultScreenHeight;
 
+    // points for winning a set that ended with finalCombo
+    static uint16_t getSetPoints(const Combo& finalCombo);
+
     // TODO: make private
     void findStartingCard(void);
     void scoreGame(const std::string& name, const Combo& finalCombo);
 
   private:
-    Deck      _deck;
+    Rules     _rules;
 
     ScoreMapT   _scores;
 
@@ -68,13 +140,26 @@ class Game
     std::vector<Player *> _players;
     uint16_t  _screenHeight;
     uint16_t  _numSets;
+    uint16_t  _setWinner;
+    uint16_t  _startingSeat;
+    // seat whose turn is next while a round is open
+    uint16_t  _toMove;
+    bool      _roundOpen;
+    bool      _interactive;
+    uint64_t  _seed;
+    uint64_t  _nextDeal;
+
+    GameRecordWriter* _recordWriter;
+    GameRecord        _record;
+
+    GameEventSink*    _sink;
 
     void _setupSuits(void);
     void _setupPlayers(void);
+    void _setupPlayers(const std::vector<std::string>& lineup);
 
-    void _createDeck(void);
+    void _playSet(std::ostream& os);
 
-    void _promptForEnter(void);
 
 };
 
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <sstream>
+#include <iostream>
+
+// game
+#include "Util.h"
+
+#include "Game.h"
+#include "GameEventSink.h"
+
+namespace pusoydos {
+
+namespace {
+
+// combo types of transcript lines, one token each
+const char* const sComboTokens[Combo::NUMTYPES] = {
+    "single", "pair", "three", "straight", "flush", "fullhouse", "four", "straightflush"
+};
+
+} /* anonymous namespace */
+
+/****************************************************
+ ***************** GameEventSink ********************
+ ****************************************************/
+
+GameEventSink::~GameEventSink(void)
+{
+}
+
+void
+GameEventSink::onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers)
+{
+}
+
+void
+GameEventSink::onRoundStart(const uint8_t leader)
+{
+}
+
+void
+GameEventSink::onTurn(const uint8_t seat)
+{
+}
+
+void
+GameEventSink::onLead(const uint8_t seat, const Combo& combo)
+{
+}
+
+void
+GameEventSink::onFollow(const uint8_t seat, const Combo& combo)
+{
+}
+
+void
+GameEventSink::onPass(const uint8_t seat)
+{
+}
+
+void
+GameEventSink::onRoundWon(const uint8_t seat)
+{
+}
+
+void
+GameEventSink::onSetWon(const uint8_t seat, const uint16_t points)
+{
+}
+
+void
+GameEventSink::onGameWon(const uint8_t seat)
+{
+}
+
+GameEventSink*
+GameEventSink::null(void)
+{
+    static GameEventSink sink;
+    return &sink;
+}
+
+/****************************************************
+ ***************** TextEventSink ********************
+ ****************************************************/
+
+TextEventSink::TextEventSink(const Game& game, std::ostream& os,
+                             const uint16_t humanSeat, const uint16_t screenHeight)
+    : _game(game),
+      _os(os),
+      _humanSeat(humanSeat),
+      _screenHeight(screenHeight)
+{
+}
+
+void
+TextEventSink::onRoundStart(const uint8_t leader)
+{
+    for (uint16_t i = 0; i < _game.getNumPlayers(); ++i) {
+        _game.getPlayer(i)->printHand(_os);
+        _os << "\n";
+    }
+    _os << "Starting round, leader: " << _game.getPlayer(leader)->getName() << "\n\n";
+    _pile.clear();
+}
+
+void
+TextEventSink::onTurn(const uint8_t seat)
+{
+    if (seat == _humanSeat) {
+        _os << _pile;
+    }
+}
+
+void
+TextEventSink::onLead(const uint8_t seat, const Combo& combo)
+{
+    _addToPile(seat, combo);
+    _endTurn(seat);
+}
+
+void
+TextEventSink::onFollow(const uint8_t seat, const Combo& combo)
+{
+    _addToPile(seat, combo);
+    _endTurn(seat);
+}
+
+void
+TextEventSink::onPass(const uint8_t seat)
+{
+    _endTurn(seat);
+}
+
+void
+TextEventSink::onRoundWon(const uint8_t seat)
+{
+    _os << "\nAll other players have passed. "
+        << _game.getPlayer(seat)->getName()
+        << " wins the round.\n\n";
+    if (_humanSeat < _game.getNumPlayers()) {
+        promptForEnter();
+    }
+}
+
+void
+TextEventSink::onSetWon(const uint8_t seat, const uint16_t points)
+{
+    _os << _game.getPlayer(seat)->getName() << " WINS!\n";
+}
+
+void
+TextEventSink::onGameWon(const uint8_t seat)
+{
+    _os << "=========== GAME OVER ============\n";
+    _os << "WINNER: " << std::right << _game.getPlayer(seat)->getName() << " !!!\n\n";
+    _os << "==================================\n";
+}
+
+void
+TextEventSink::promptForEnter(void)
+{
+    std::string enter;
+    printf("\n\n<Press Enter>");
+    std::cin.ignore(10000,'\n');
+    std::getline( std::cin, enter );
+}
+
+void
+TextEventSink::_addToPile(const uint8_t seat, const Combo& combo)
+{
+    std::ostringstream oss;
+    combo.printToStream(oss, _game.getRules(), _game.getPlayer(seat)->getName());
+    _pile += oss.str();
+}
+
+void
+TextEventSink::_endTurn(const uint8_t seat)
+{
+    if (seat == _humanSeat) {
+        _os << _pile;
+        promptForEnter();
+        Util::clearScreen(_os, _screenHeight);
+    }
+}
+
+/****************************************************
+ ************** TranscriptEventSink *****************
+ ****************************************************/
+
+TranscriptEventSink::TranscriptEventSink(const Rules& rules, AsyncLogWriter::Channel* channel)
+    : _channel(channel),
+      _gameId(0)
+{
+    for (uint16_t code = 0; code < CardSet::sNumCards; ++code) {
+        std::ostringstream oss;
+        rules.getCard(code)->printToStream(oss);
+        _cardNames[code] = oss.str();
+    }
+    _line.reserve(256);
+}
+
+void
+TranscriptEventSink::onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers)
+{
+    _gameId = gameId;
+    _begin("deal");
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        if (i > 0) {
+            _line += " /";
+        }
+        _addCards(hands[i]);
+    }
+    _end();
+}
+
+void
+TranscriptEventSink::onLead(const uint8_t seat, const Combo& combo)
+{
+    _addCombo("lead", seat, combo);
+}
+
+void
+TranscriptEventSink::onFollow(const uint8_t seat, const Combo& combo)
+{
+    _addCombo("follow", seat, combo);
+}
+
+void
+TranscriptEventSink::onPass(const uint8_t seat)
+{
+    _begin("pass");
+    _addNumber(seat + 1);
+    _end();
+}
+
+void
+TranscriptEventSink::onRoundWon(const uint8_t seat)
+{
+    _begin("round");
+    _addNumber(seat + 1);
+    _end();
+}
+
+void
+TranscriptEventSink::onSetWon(const uint8_t seat, const uint16_t points)
+{
+    _begin("won");
+    _addNumber(seat + 1);
+    _addNumber(points);
+    _end();
+}
+
+void
+TranscriptEventSink::_begin(const char* event)
+{
+    // the line keeps its capacity, formatting does not allocate
+    _line.clear();
+    char digits[24];
+    int n = 0;
+    uint64_t id = _gameId;
+    do {
+        digits[n++] = '0' + id % 10;
+        id /= 10;
+    }
+    while (id > 0);
+    while (n > 0) {
+        _line += digits[--n];
+    }
+    _line += ' ';
+    _line += event;
+}
+
+void
+TranscriptEventSink::_addNumber(const uint64_t n)
+{
+    char digits[24];
+    int count = 0;
+    uint64_t v = n;
+    do {
+        digits[count++] = '0' + v % 10;
+        v /= 10;
+    }
+    while (v > 0);
+    _line += ' ';
+    while (count > 0) {
+        _line += digits[--count];
+    }
+}
+
+void
+TranscriptEventSink::_addCards(const CardSet& cards)
+{
+    for (CardSet::MaskT m = cards.getMask(); m; m &= m - 1) {
+        _line += ' ';
+        _line += _cardNames[__builtin_ctzll(m)];
+    }
+}
+
+void
+TranscriptEventSink::_addCombo(const char* event, const uint8_t seat, const Combo& combo)
+{
+    _begin(event);
+    _addNumber(seat + 1);
+    _line += ' ';
+    _line += sComboTokens[combo.getType()];
+    _addCards(combo.getCardSet());
+    _end();
+}
+
+void
+TranscriptEventSink::_end(void)
+{
+    _line += '\n';
+    _channel->append(_line);
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,115 @@
+#ifndef _PUSOYDOS_GAMEEVENTSINK_H_
+#define _PUSOYDOS_GAMEEVENTSINK_H_
+
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+// pusoydos
+#include "AsyncLogWriter.h"
+#include "CardSet.h"
+#include "Combo.h"
+#include "Rules.h"
+
+namespace pusoydos {
+
+class Game;
+
+// receives the events of a game as plain values; anything a consumer shows
+// is formatted by the consumer, so a game nobody watches formats nothing.
+// Every handler defaults to doing nothing.
+class GameEventSink
+{
+  public:
+    virtual ~GameEventSink(void);
+
+    // hands[seat] of deal gameId (see Game::deal)
+    virtual void onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers);
+    virtual void onRoundStart(const uint8_t leader);
+    // seat is about to choose a combo
+    virtual void onTurn(const uint8_t seat);
+    virtual void onLead(const uint8_t seat, const Combo& combo);
+    virtual void onFollow(const uint8_t seat, const Combo& combo);
+    virtual void onPass(const uint8_t seat);
+    // everyone else passed on the combo of seat
+    virtual void onRoundWon(const uint8_t seat);
+    // seat ran out of cards
+    virtual void onSetWon(const uint8_t seat, const uint16_t points);
+    virtual void onGameWon(const uint8_t seat);
+
+    // shared sink that ignores every event
+    static GameEventSink* null(void);
+};
+
+// the console view: shows hands at the start of each round, the combos
+// played so far to the human player before and after each turn, and waits
+// for Enter at the human player's turns and round ends
+class TextEventSink : public GameEventSink
+{
+  public:
+    // humanSeat of the number of players or more for no human player (no
+    // prompts)
+    TextEventSink(const Game& game, std::ostream& os,
+                  const uint16_t humanSeat, const uint16_t screenHeight);
+
+    virtual void onRoundStart(const uint8_t leader);
+    virtual void onTurn(const uint8_t seat);
+    virtual void onLead(const uint8_t seat, const Combo& combo);
+    virtual void onFollow(const uint8_t seat, const Combo& combo);
+    virtual void onPass(const uint8_t seat);
+    virtual void onRoundWon(const uint8_t seat);
+    virtual void onSetWon(const uint8_t seat, const uint16_t points);
+    virtual void onGameWon(const uint8_t seat);
+
+    static void promptForEnter(void);
+
+  private:
+    const Game&   _game;
+    std::ostream& _os;
+    uint16_t      _humanSeat;
+    uint16_t      _screenHeight;
+    // combos played this round, as shown to the human player
+    std::string   _pile;
+
+    void _addToPile(const uint8_t seat, const Combo& combo);
+    void _endTurn(const uint8_t seat);
+};
+
+// one line per event for offline analysis, appended to a log channel of
+// the game's thread (see AsyncLogWriter), seats counted from 1:
+//   <game> deal <hand 1> / <hand 2> ...
+//   <game> lead|follow <seat> <combo type> <cards>
+//     combo type: single, pair, three, straight, flush, fullhouse, four or
+//     straightflush
+//   <game> pass <seat>
+//   <game> round <seat>
+//   <game> won <seat> <points>
+class TranscriptEventSink : public GameEventSink
+{
+  public:
+    TranscriptEventSink(const Rules& rules, AsyncLogWriter::Channel* channel);
+
+    virtual void onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers);
+    virtual void onLead(const uint8_t seat, const Combo& combo);
+    virtual void onFollow(const uint8_t seat, const Combo& combo);
+    virtual void onPass(const uint8_t seat);
+    virtual void onRoundWon(const uint8_t seat);
+    virtual void onSetWon(const uint8_t seat, const uint16_t points);
+
+  private:
+    AsyncLogWriter::Channel* _channel;
+    uint64_t    _gameId;
+    // card names by code, formatted once
+    std::string _cardNames[CardSet::sNumCards];
+    std::string _line;
+
+    void _begin(const char* event);
+    void _addNumber(const uint64_t n);
+    void _addCards(const CardSet& cards);
+    void _addCombo(const char* event, const uint8_t seat, const Combo& combo);
+    void _end(void);
+};
+
+} /* namespace pusoydos */
+
+#endif
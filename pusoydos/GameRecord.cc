@@ -0,0 +1,303 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdexcept>
+
+#include "GameRecord.h"
+
+namespace pusoydos {
+
+namespace {
+
+// turn word fields
+const uint16_t sSeatShift = 52;
+const uint16_t sTypeShift = 56;
+
+static_assert(sizeof(GameRecord::FileHeader) == 8, "file header must stay 8 bytes");
+static_assert(sizeof(GameRecord::Header) % 8 == 0, "records must stay 8-byte aligned");
+
+std::runtime_error
+systemError(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+} /* anonymous namespace */
+
+const char GameRecord::sMagic[4] = { 'P', 'D', 'G', 'R' };
+const uint16_t GameRecord::sVersion;
+const uint32_t GameRecordWriter::sBufferSize;
+
+/****************************************************
+ ******************* GameRecord *********************
+ ****************************************************/
+
+GameRecord::GameRecord(void)
+{
+    memset(&_header, 0, sizeof(_header));
+}
+
+void
+GameRecord::begin(const uint64_t seed, const uint64_t gameId,
+                  const uint16_t numPlayers, const CardSet* hands)
+{
+    memset(&_header, 0, sizeof(_header));
+    _header.numPlayers = numPlayers;
+    _header.seed = seed;
+    _header.gameId = gameId;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        _header.hands[i] = hands[i].getMask();
+    }
+    _turns.clear();
+}
+
+void
+GameRecord::addTurn(const uint8_t seat, const Combo& combo)
+{
+    _turns.push_back(encodeTurn(seat, combo));
+}
+
+void
+GameRecord::finish(const uint8_t winner, const uint16_t points)
+{
+    if (_turns.size() > 0xFFFF) {
+        throw std::length_error("too many turns for game record");
+    }
+    _header.numTurns = _turns.size();
+    _header.winner = winner;
+    _header.points = points;
+    _header.size = sizeof(Header) + _turns.size() * sizeof(uint64_t);
+}
+
+const GameRecord::Header&
+GameRecord::getHeader(void) const
+{
+    return _header;
+}
+
+const uint64_t*
+GameRecord::getTurns(void) const
+{
+    return _turns.data();
+}
+
+uint64_t
+GameRecord::encodeTurn(const uint8_t seat, const Combo& combo)
+{
+    if (combo.getSize() == 0) {
+        return ((uint64_t)seat << sSeatShift) | ((uint64_t)Combo::kUndef << sTypeShift);
+    }
+    return combo.getCardSet().getMask() | ((uint64_t)seat << sSeatShift) |
+           ((uint64_t)combo.getType() << sTypeShift);
+}
+
+uint8_t
+GameRecord::getTurnSeat(const uint64_t turn)
+{
+    return (turn >> sSeatShift) & 0xF;
+}
+
+CardSet
+GameRecord::getTurnCards(const uint64_t turn)
+{
+    return CardSet(turn & CardSet::sFullMask);
+}
+
+Combo::ComboT
+GameRecord::getTurnType(const uint64_t turn)
+{
+    return (Combo::ComboT)((turn >> sTypeShift) & 0xF);
+}
+
+Combo
+GameRecord::decodeTurn(const uint64_t turn)
+{
+    Combo combo;
+    CardSet cards = getTurnCards(turn);
+    if (!cards.empty()) {
+        combo.setType(getTurnType(turn));
+        combo.setCards(cards);
+    }
+    combo.setOwner(getTurnSeat(turn));
+    return combo;
+}
+
+/****************************************************
+ **************** GameRecordWriter ******************
+ ****************************************************/
+
+GameRecordWriter::GameRecordWriter(const std::string& path)
+    : _fd(-1),
+      _numRecords(0)
+{
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (_fd < 0) {
+        throw systemError("cannot open game record file", path);
+    }
+    GameRecord::FileHeader header;
+    ssize_t n = pread(_fd, &header, sizeof(header), 0);
+    if (n == 0) {
+        memcpy(header.magic, GameRecord::sMagic, sizeof(header.magic));
+        header.version = GameRecord::sVersion;
+        header.headerSize = sizeof(header);
+        if (write(_fd, &header, sizeof(header)) != sizeof(header)) {
+            close(_fd);
+            throw systemError("cannot write game record file", path);
+        }
+    }
+    else if (n != sizeof(header) ||
+             memcmp(header.magic, GameRecord::sMagic, sizeof(header.magic)) != 0 ||
+             header.version != GameRecord::sVersion) {
+        close(_fd);
+        throw std::runtime_error("not a version " + std::to_string(GameRecord::sVersion) +
+                                 " game record file: " + path);
+    }
+    _buffer.reserve(sBufferSize);
+}
+
+GameRecordWriter::~GameRecordWriter(void)
+{
+    try {
+        flush();
+    }
+    catch (...) {
+        // nowhere to report a failed final write
+    }
+    close(_fd);
+}
+
+void
+GameRecordWriter::append(const GameRecord& record)
+{
+    const GameRecord::Header& header = record.getHeader();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_buffer.size() + header.size > sBufferSize) {
+        _flushLocked();
+    }
+    const char* h = (const char*)&header;
+    const char* t = (const char*)record.getTurns();
+    _buffer.insert(_buffer.end(), h, h + sizeof(header));
+    _buffer.insert(_buffer.end(), t, t + header.numTurns * sizeof(uint64_t));
+    ++_numRecords;
+}
+
+void
+GameRecordWriter::flush(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flushLocked();
+}
+
+uint64_t
+GameRecordWriter::getNumRecords(void) const
+{
+    return _numRecords;
+}
+
+void
+GameRecordWriter::_flushLocked(void)
+{
+    // the buffer only holds whole records, so each write appends whole
+    // records even with other writers on the same file
+    size_t done = 0;
+    while (done < _buffer.size()) {
+        ssize_t n = write(_fd, _buffer.data() + done, _buffer.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("cannot write game records: ") + strerror(errno));
+        }
+        done += n;
+    }
+    _buffer.clear();
+}
+
+/****************************************************
+ **************** GameRecordReader ******************
+ ****************************************************/
+
+GameRecordReader::GameRecordReader(const std::string& path)
+    : _data(NULL),
+      _size(0),
+      _offset(0),
+      _start(0),
+      _version(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw systemError("cannot open game record file", path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw systemError("cannot stat game record file", path);
+    }
+    _size = st.st_size;
+    if (_size < sizeof(GameRecord::FileHeader)) {
+        close(fd);
+        throw std::runtime_error("not a game record file: " + path);
+    }
+    void* mem = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        throw systemError("cannot map game record file", path);
+    }
+    _data = (const char*)mem;
+    // records are read front to back once
+    madvise(mem, _size, MADV_SEQUENTIAL);
+
+    const GameRecord::FileHeader* header = (const GameRecord::FileHeader*)_data;
+    if (memcmp(header->magic, GameRecord::sMagic, sizeof(header->magic)) != 0 ||
+        header->version != GameRecord::sVersion ||
+        header->headerSize < sizeof(GameRecord::FileHeader) || header->headerSize > _size) {
+        munmap(mem, _size);
+        throw std::runtime_error("not a version " + std::to_string(GameRecord::sVersion) +
+                                 " game record file: " + path);
+    }
+    _version = header->version;
+    _start = header->headerSize;
+    _offset = _start;
+}
+
+GameRecordReader::~GameRecordReader(void)
+{
+    munmap((void*)_data, _size);
+}
+
+bool
+GameRecordReader::next(RecordView& view)
+{
+    if (_offset == _size) {
+        return false;
+    }
+    if (_size - _offset < sizeof(GameRecord::Header)) {
+        throw std::runtime_error("truncated game record");
+    }
+    const GameRecord::Header* header = (const GameRecord::Header*)(_data + _offset);
+    if (header->size != sizeof(GameRecord::Header) + header->numTurns * sizeof(uint64_t) ||
+        header->size > _size - _offset || header->numPlayers > GameState::sMaxPlayers) {
+        throw std::runtime_error("corrupt game record");
+    }
+    view.header = header;
+    view.turns = (const uint64_t*)(header + 1);
+    _offset += header->size;
+    return true;
+}
+
+void
+GameRecordReader::rewind(void)
+{
+    _offset = _start;
+}
+
+uint16_t
+GameRecordReader::getVersion(void) const
+{
+    return _version;
+}
+
+} /* namespace pusoydos */
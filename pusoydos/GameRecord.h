@@ -0,0 +1,141 @@
+#ifndef _PUSOYDOS_GAMERECORD_H_
+#define _PUSOYDOS_GAMERECORD_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+#include "GameState.h"
+
+namespace pusoydos {
+
+// binary record of one set, the unit of the game-record file format.
+//
+// A file is a FileHeader followed by records; all fields are little-endian
+// and 8-byte aligned so records can be read in place. A record is a Header
+// (whose size covers the whole record) followed by one 64-bit word per
+// turn: the played cards in bits 0-51 (none for a pass), the seat in bits
+// 52-55 and the combo type in bits 56-59 (kUndef for a pass).
+class GameRecord
+{
+  public:
+    class FileHeader
+    {
+      public:
+        char     magic[4];
+        uint16_t version;
+        uint16_t headerSize;
+    };
+
+    class Header
+    {
+      public:
+        // bytes of the record, header and turns
+        uint32_t size;
+        uint16_t numTurns;
+        uint8_t  numPlayers;
+        // seat that went out first and the points it scored
+        uint8_t  winner;
+        uint16_t points;
+        uint8_t  reserved[6];
+        // deal, see Game::deal(seed, index)
+        uint64_t seed;
+        uint64_t gameId;
+        uint64_t hands[GameState::sMaxPlayers];
+    };
+
+    GameRecord(void);
+
+    // starts a new record with the dealt hands
+    void begin(const uint64_t seed, const uint64_t gameId,
+               const uint16_t numPlayers, const CardSet* hands);
+    // seat played combo, or passed if combo is empty
+    void addTurn(const uint8_t seat, const Combo& combo);
+    void finish(const uint8_t winner, const uint16_t points);
+
+    const Header& getHeader(void) const;
+    const uint64_t* getTurns(void) const;
+
+    static uint64_t encodeTurn(const uint8_t seat, const Combo& combo);
+    static uint8_t getTurnSeat(const uint64_t turn);
+    static CardSet getTurnCards(const uint64_t turn);
+    // kUndef for a pass
+    static Combo::ComboT getTurnType(const uint64_t turn);
+    // the combo played (empty for a pass), owned by the turn's seat
+    static Combo decodeTurn(const uint64_t turn);
+
+    static const char     sMagic[4];
+    static const uint16_t sVersion = 1;
+
+  private:
+    Header _header;
+    std::vector<uint64_t> _turns;
+};
+
+// append-only writer of game records. Records are buffered in memory and
+// written with one system call per buffer; append() may be called from
+// several threads, each record is written whole.
+class GameRecordWriter
+{
+  public:
+    // opens (creating if needed) path for appending; a new file gets the
+    // file header, an existing one must have a matching header
+    GameRecordWriter(const std::string& path);
+
+    ~GameRecordWriter(void);
+
+    void append(const GameRecord& record);
+    void flush(void);
+
+    uint64_t getNumRecords(void) const;
+
+    static const uint32_t sBufferSize = 1 << 20;
+
+  private:
+    int               _fd;
+    std::vector<char> _buffer;
+    uint64_t          _numRecords;
+    std::mutex        _mutex;
+
+    void _flushLocked(void);
+};
+
+// reader over a memory-mapped game-record file; records are read in place
+// without copying
+class GameRecordReader
+{
+  public:
+    // view of one record inside the mapping, valid while the reader lives
+    class RecordView
+    {
+      public:
+        const GameRecord::Header* header;
+        const uint64_t*           turns;
+    };
+
+    GameRecordReader(const std::string& path);
+
+    ~GameRecordReader(void);
+
+    // next record; false at the end of the file. Throws on a truncated or
+    // corrupt record.
+    bool next(RecordView& view);
+    void rewind(void);
+
+    uint16_t getVersion(void) const;
+
+  private:
+    const char* _data;
+    uint64_t    _size;
+    uint64_t    _offset;
+    uint64_t    _start;
+    uint16_t    _version;
+};
+
+} /* namespace pusoydos */
+
+#endif
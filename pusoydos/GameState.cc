@@ -1,11 +1,17 @@
+#include <algorithm>
+
 #include "GameState.h"
 
 namespace pusoydos {
 
+const uint16_t GameState::sMaxPlayers;
+
 GameState::GameState(void)
     : leadPlayer(0),
-      firstCombo(false)
+      firstCombo(false),
+      numPlayers(0)
 {
+    std::fill(cardsLeft, cardsLeft + sMaxPlayers, 0);
 }
 
 void
@@ -14,6 +20,8 @@ GameState::reset(void)
     combo.resetAll();
     leadPlayer = 0;
     firstCombo = false;
+    played.clear();
+    std::fill(cardsLeft, cardsLeft + sMaxPlayers, 0);
 }
 
 } /* namespace pusoydos */
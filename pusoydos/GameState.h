@@ -1,6 +1,7 @@
 #ifndef _PUSOYDOS_GAMESTATE_H_
 #define _PUSOYDOS_GAMESTATE_H_
 
+#include "CardSet.h"
 #include "Combo.h"
 
 namespace pusoydos {
@@ -12,9 +13,16 @@ class GameState
 
     void reset(void);
 
+    static const uint16_t sMaxPlayers = 4;
+
     Combo    combo;
     uint16_t leadPlayer;
     bool     firstCombo;
+    // all cards played so far in the current set
+    CardSet  played;
+    // cards left per seat (public information)
+    uint16_t numPlayers;
+    uint16_t cardsLeft[sMaxPlayers];
 };
 
 } /* namespace pusoydos */
@@ -0,0 +1,512 @@
+#include <math.h>
+#include <stdlib.h>
+#include <stdexcept>
+#include <functional>
+
+#include "MctsPlayer.h"
+#include "MoveGenerator.h"
+
+namespace pusoydos {
+
+namespace {
+
+// UCB exploration constant for wins in [0, 1]
+const double sExploration = 0.7;
+
+uint32_t
+parseNumber(const std::string& token, const std::string& type)
+{
+    char* end = NULL;
+    unsigned long value = strtoul(token.c_str(), &end, 10);
+    if (token.empty() || *end != '\0' || value == 0 || value > 0xFFFFFFFFul) {
+        throw std::invalid_argument("invalid ismcts player type: " + type);
+    }
+    return value;
+}
+
+} /* anonymous namespace */
+
+const uint32_t MctsPlayer::sDefaultPlayouts;
+const uint32_t MctsPlayer::sNoNode;
+
+MctsPlayer::Budget::Budget(void)
+    : playouts(sDefaultPlayouts),
+      millis(0),
+      threads(1)
+{
+}
+
+MctsPlayer::Budget
+MctsPlayer::Budget::parse(const std::string& type)
+{
+    std::vector<std::string> tokens;
+    std::string::size_type start = 0;
+    while (true) {
+        std::string::size_type colon = type.find(':', start);
+        tokens.push_back(type.substr(start, colon - start));
+        if (colon == std::string::npos) {
+            break;
+        }
+        start = colon + 1;
+    }
+    if (tokens[0] != "ismcts" || tokens.size() > 3) {
+        throw std::invalid_argument("invalid ismcts player type: " + type);
+    }
+
+    Budget budget;
+    if (tokens.size() > 1) {
+        const std::string& limit = tokens[1];
+        if (limit.size() > 2 && limit.compare(limit.size() - 2, 2, "ms") == 0) {
+            budget.millis = parseNumber(limit.substr(0, limit.size() - 2), type);
+        }
+        else {
+            budget.playouts = parseNumber(limit, type);
+        }
+    }
+    if (tokens.size() > 2) {
+        uint32_t threads = parseNumber(tokens[2], type);
+        if (threads > 0xFFFF) {
+            throw std::invalid_argument("invalid ismcts player type: " + type);
+        }
+        budget.threads = threads;
+    }
+    return budget;
+}
+
+MctsPlayer::MctsPlayer(const std::string name, const Budget& budget)
+    : Player(name),
+      _budget(budget),
+      _pool(NULL),
+      _workers(budget.threads),
+      _playouts(0),
+      _state(NULL),
+      _searching(0),
+      _cancelled(false),
+      _failed(false),
+      _running(false)
+{
+    for (uint16_t w = 0; w < _workers.size(); ++w) {
+        // room for every play plus a pass
+        _workers[w].moves.resize(MoveGenerator::sMaxMoves + 1);
+        _workers[w].untried.reserve(MoveGenerator::sMaxMoves + 1);
+    }
+}
+
+MctsPlayer::~MctsPlayer(void)
+{
+    // stops a pending search before the members go
+    _cancelled = true;
+    _waitSearch();
+}
+
+const Combo&
+MctsPlayer::playLeadCombo(const GameState* state)
+{
+    _combo.resetAll();
+    _combo.setOwner(_seat);
+    return _takeMove(_search(state));
+}
+
+bool
+MctsPlayer::playFollowCombo(const GameState* state, Combo& combo)
+{
+    if (_hand.empty()) {
+        return false;
+    }
+    _combo.resetAll();
+    _combo.setOwner(_seat);
+    if (!_search(state)) {
+        return false;
+    }
+    combo = _takeMove(true);
+    return true;
+}
+
+bool
+MctsPlayer::requestMove(const GameState* state, Combo& move, const ResumeFn& resume)
+{
+    if (_hand.empty()) {
+        return Player::requestMove(state, move, resume);
+    }
+    _combo.resetAll();
+    _combo.setOwner(_seat);
+    bool play = false;
+    if (_beginSearch(state, play)) {
+        move = _takeMove(play);
+        return true;
+    }
+    _resume = resume;
+    _startWorkers();
+    return false;
+}
+
+void
+MctsPlayer::waitForMove(void)
+{
+    _waitSearch();
+}
+
+void
+MctsPlayer::cancelMove(void)
+{
+    _cancelled = true;
+    _waitSearch();
+    _resume = ResumeFn();
+}
+
+void
+MctsPlayer::setSearchPool(ThreadPool* pool)
+{
+    _pool = pool;
+}
+
+void
+MctsPlayer::seedRandom(const uint64_t seed, const uint64_t gameId)
+{
+    Player::seedRandom(seed, gameId);
+    for (uint16_t w = 0; w < _workers.size(); ++w) {
+        _workers[w].rng = RandomStream(seed, gameId, RandomStream::getSeatStream(_seat, w + 1));
+    }
+}
+
+bool
+MctsPlayer::listsPlays(void) const
+{
+    return true;
+}
+
+const MctsPlayer::Budget&
+MctsPlayer::getBudget(void) const
+{
+    return _budget;
+}
+
+bool
+MctsPlayer::_search(const GameState* state)
+{
+    bool play = false;
+    if (_beginSearch(state, play)) {
+        return play;
+    }
+    _startWorkers();
+    _waitSearch();
+    std::exception_ptr error;
+    error.swap(_error);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return _endSearch();
+}
+
+bool
+MctsPlayer::_beginSearch(const GameState* state, bool& play)
+{
+    CardSet hands[GameState::sMaxPlayers];
+    hands[_seat] = _hand;
+    _state = state;
+    _root = Position(*state, _seat, hands);
+    _unseen = Position::getUnseen(*state, _hand);
+
+    // forced plays need no search
+    Combo* moves = &_workers[0].moves[0];
+    uint16_t numMoves = _root.generateMoves(moves, MoveGenerator::sMaxMoves);
+    if (numMoves == 0) {
+        play = false;
+        return true;
+    }
+    if (numMoves == 1 && !_root.canPass()) {
+        _combo = moves[0];
+        _combo.setOwner(_seat);
+        play = true;
+        return true;
+    }
+    _fallback = moves[0];
+    return false;
+}
+
+void
+MctsPlayer::_startWorkers(void)
+{
+    _deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_budget.millis);
+    _playouts = 0;
+    _cancelled = false;
+    _failed = false;
+    _searching = _workers.size();
+    if (!_pool) {
+        if (!_ownPool) {
+            _ownPool.reset(new ThreadPool(_workers.size()));
+        }
+        _pool = _ownPool.get();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_searchMutex);
+        _running = true;
+        _error = std::exception_ptr();
+    }
+    for (uint16_t w = 0; w < _workers.size(); ++w) {
+        // fits the small buffer of std::function, so submitting allocates no task
+        Worker* worker = &_workers[w];
+        _pool->submit([this, worker] { _runWorker(worker); });
+    }
+}
+
+void
+MctsPlayer::_waitSearch(void)
+{
+    std::unique_lock<std::mutex> lock(_searchMutex);
+    _searchDone.wait(lock, [this] { return !_running; });
+}
+
+bool
+MctsPlayer::_endSearch(void)
+{
+    // merge root visit counts of all workers
+    ArenaAllocator<Node> alloc(&_arena);
+    std::vector<Node, ArenaAllocator<Node> > merged(alloc);
+    for (uint16_t w = 0; w < _workers.size(); ++w) {
+        const std::vector<Node>& nodes = _workers[w].nodes;
+        for (uint32_t c = nodes[0].firstChild; c != sNoNode; c = nodes[c].nextSibling) {
+            uint32_t m = 0;
+            while (m < merged.size() && !_isSameMove(merged[m].move, nodes[c].move)) {
+                ++m;
+            }
+            if (m == merged.size()) {
+                merged.push_back(nodes[c]);
+            }
+            else {
+                merged[m].visits += nodes[c].visits;
+            }
+        }
+    }
+    if (merged.empty()) {
+        // budget ran out before a single playout
+        _combo = _fallback;
+        _combo.setOwner(_seat);
+        return true;
+    }
+    uint32_t best = 0;
+    for (uint32_t m = 1; m < merged.size(); ++m) {
+        if (merged[m].visits > merged[best].visits) {
+            best = m;
+        }
+    }
+    if (merged[best].move.getSize() == 0) {
+        return false;
+    }
+    _combo = merged[best].move;
+    _combo.setOwner(_seat);
+    return true;
+}
+
+const Combo&
+MctsPlayer::_takeMove(const bool play)
+{
+    if (play) {
+        _removeCards(_combo.getCardSet());
+    }
+    else {
+        _combo.resetAll();
+        _combo.setOwner(_seat);
+    }
+    return _combo;
+}
+
+void
+MctsPlayer::_runWorker(Worker* worker)
+{
+    try {
+        worker->nodes.clear();
+        _addChild(*worker, sNoNode, Combo(), Combo::sNoOwner);
+        while (!_cancelled && !_failed) {
+            if (_budget.millis > 0) {
+                if (std::chrono::steady_clock::now() >= _deadline) {
+                    break;
+                }
+            }
+            else if (_playouts.fetch_add(1) >= _budget.playouts) {
+                break;
+            }
+            _iterate(*worker, *_state, _root, _unseen);
+        }
+    }
+    catch (...) {
+        // kept for the search instead of the pool, which may be shared;
+        // the other workers stop too
+        std::lock_guard<std::mutex> lock(_searchMutex);
+        if (!_error) {
+            _error = std::current_exception();
+        }
+        _failed = true;
+    }
+    if (_searching.fetch_sub(1) > 1) {
+        return;
+    }
+    // the other workers are done with their trees and errors; a
+    // synchronous search (no _resume) merges after its wait instead
+    std::exception_ptr failure;
+    if (_resume) {
+        ResumeFn resume;
+        resume.swap(_resume);
+        if (!_cancelled) {
+            Combo move;
+            std::exception_ptr error = _error;
+            if (!error) {
+                try {
+                    move = _takeMove(_endSearch());
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            try {
+                resume(move, error);
+            }
+            catch (...) {
+                // the driver broke, nobody but the pool is left to tell
+                failure = std::current_exception();
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(_searchMutex);
+        _running = false;
+        _searchDone.notify_all();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void
+MctsPlayer::_iterate(Worker& worker, const GameState& state, const Position& root,
+                     const CardSet& unseen)
+{
+    std::vector<Node>& nodes = worker.nodes;
+    Combo* moves = &worker.moves[0];
+    Position pos = root;
+    pos.dealHidden(state, _seat, unseen, worker.rng);
+
+    // selection, restricted to the moves legal in this deal, until a node
+    // with an untried move is reached, which is expanded
+    uint32_t node = 0;
+    while (!pos.isTerminal()) {
+        uint16_t numMoves = pos.generateMoves(moves, MoveGenerator::sMaxMoves);
+        if (pos.canPass()) {
+            moves[numMoves++] = Combo();
+        }
+        uint16_t numLegal = 0;
+        for (uint32_t c = nodes[node].firstChild; c != sNoNode; c = nodes[c].nextSibling) {
+            if (_isLegal(nodes[c].move, pos)) {
+                ++numLegal;
+            }
+        }
+        if (numLegal < numMoves) {
+            worker.untried.clear();
+            for (uint16_t i = 0; i < numMoves; ++i) {
+                uint32_t c = nodes[node].firstChild;
+                while (c != sNoNode && !_isSameMove(nodes[c].move, moves[i])) {
+                    c = nodes[c].nextSibling;
+                }
+                if (c == sNoNode) {
+                    worker.untried.push_back(i);
+                }
+            }
+            if (!worker.untried.empty()) {
+                const Combo& move = moves[worker.untried[worker.rng.below(worker.untried.size())]];
+                node = _addChild(worker, node, move, pos.toMove);
+                _playMove(pos, move);
+                break;
+            }
+        }
+
+        uint32_t best = sNoNode;
+        double bestScore = -1.0;
+        for (uint32_t c = nodes[node].firstChild; c != sNoNode; c = nodes[c].nextSibling) {
+            Node& child = nodes[c];
+            if (!_isLegal(child.move, pos)) {
+                continue;
+            }
+            double score = (double)child.wins / child.visits +
+                           sExploration * sqrt(log((double)child.avails) / child.visits);
+            if (score > bestScore) {
+                best = c;
+                bestScore = score;
+            }
+            ++child.avails;
+        }
+        node = best;
+        _playMove(pos, nodes[node].move);
+    }
+
+    // random playout to the end of the set
+    while (!pos.isTerminal()) {
+        uint16_t numMoves = pos.generateMoves(moves, MoveGenerator::sMaxMoves);
+        uint16_t pick = worker.rng.below(numMoves + (pos.canPass() ? 1 : 0));
+        if (pick == numMoves) {
+            pos.pass();
+        }
+        else {
+            pos.play(moves[pick]);
+        }
+    }
+
+    uint8_t winner = pos.getWinner();
+    for (uint32_t n = node; n != sNoNode; n = nodes[n].parent) {
+        ++nodes[n].visits;
+        if (nodes[n].player == winner) {
+            ++nodes[n].wins;
+        }
+    }
+}
+
+uint32_t
+MctsPlayer::_addChild(Worker& worker, const uint32_t parent,
+                      const Combo& move, const uint8_t player)
+{
+    Node child;
+    child.move = move;
+    child.player = player;
+    child.parent = parent;
+    child.firstChild = sNoNode;
+    child.nextSibling = sNoNode;
+    child.visits = 0;
+    child.avails = 1;
+    child.wins = 0;
+    uint32_t index = worker.nodes.size();
+    if (parent != sNoNode) {
+        child.nextSibling = worker.nodes[parent].firstChild;
+        worker.nodes[parent].firstChild = index;
+    }
+    worker.nodes.push_back(child);
+    return index;
+}
+
+bool
+MctsPlayer::_isSameMove(const Combo& a, const Combo& b)
+{
+    return a.getCardSet() == b.getCardSet() &&
+           (a.getSize() == 0 || a.getType() == b.getType());
+}
+
+bool
+MctsPlayer::_isLegal(const Combo& move, const Position& pos)
+{
+    // the tree path fixes the combo to beat, so only the cards depend on the deal
+    if (move.getSize() == 0) {
+        return pos.canPass();
+    }
+    return pos.hands[pos.toMove].contains(move.getCardSet());
+}
+
+void
+MctsPlayer::_playMove(Position& pos, const Combo& move)
+{
+    if (move.getSize() == 0) {
+        pos.pass();
+    }
+    else {
+        pos.play(move);
+    }
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,155 @@
+#ifndef _PUSOYDOS_MCTSPLAYER_H_
+#define _PUSOYDOS_MCTSPLAYER_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <condition_variable>
+#include <stdint.h>
+
+// pusoydos
+#include "Player.h"
+#include "Position.h"
+#include "ThreadPool.h"
+
+namespace pusoydos {
+
+// information-set Monte Carlo tree search player (single observer ISMCTS).
+// Every iteration deals the unseen cards (not in hand, not played) to the
+// opponents at their current hand sizes, descends one shared tree using
+// only moves legal in that deal, and finishes the set with random play.
+// Search is root parallel: each worker grows its own tree and the root
+// visit counts are merged; the most visited play is chosen. requestMove
+// searches on the search pool and the last worker to finish resumes.
+class MctsPlayer : public Player
+{
+  public:
+    // per-move budget: a wall-clock limit when millis is set, otherwise a
+    // playout count shared by all workers; never exceeded by more than the
+    // one playout in flight per worker
+    class Budget
+    {
+      public:
+        Budget(void);
+
+        uint32_t playouts;
+        uint32_t millis;
+        uint16_t threads;
+
+        // parses the options of an "ismcts[:<playouts>|:<N>ms][:<threads>]"
+        // lineup type, e.g. "ismcts:2000", "ismcts:50ms:4"
+        static Budget parse(const std::string& type);
+    };
+
+    MctsPlayer(const std::string name, const Budget& budget = Budget());
+
+    ~MctsPlayer(void);
+
+    virtual const Combo& playLeadCombo(const GameState* state);
+    virtual bool playFollowCombo(const GameState* state, Combo& combo);
+
+    virtual bool requestMove(const GameState* state, Combo& move, const ResumeFn& resume);
+    virtual void waitForMove(void);
+    virtual void cancelMove(void);
+
+    // also gives every search worker its own sub-stream of the seat
+    virtual void seedRandom(const uint64_t seed, const uint64_t gameId);
+
+    // every search step lists the plays of a hand
+    virtual bool listsPlays(void) const;
+
+    // queues the budget's workers on pool (not owned, shared with other
+    // players, e.g. all the tables of a server loop) instead of on a pool
+    // of the player's own with a thread per worker, which is only created
+    // by the first search without one; not while a move is pending
+    void setSearchPool(ThreadPool* pool);
+
+    const Budget& getBudget(void) const;
+
+    static const uint32_t sDefaultPlayouts = 1000;
+
+  private:
+    class Node
+    {
+      public:
+        Combo    move;
+        // seat that made move
+        uint8_t  player;
+        uint32_t parent;
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        uint32_t visits;
+        uint32_t avails;
+        uint32_t wins;
+    };
+
+    class Worker
+    {
+      public:
+        std::vector<Node>  nodes;
+        std::vector<Combo> moves;
+        std::vector<uint16_t> untried;
+        RandomStream      rng;
+    };
+
+    Budget _budget;
+    std::unique_ptr<ThreadPool> _ownPool;
+    ThreadPool* _pool;
+    std::vector<Worker> _workers;
+    // playouts started for the current move
+    std::atomic<uint32_t> _playouts;
+
+    // the search of the current move, read by the workers
+    const GameState* _state;
+    Position _root;
+    CardSet  _unseen;
+    Combo    _fallback;
+    std::chrono::steady_clock::time_point _deadline;
+    // workers still searching, the last one resumes
+    std::atomic<uint16_t> _searching;
+    std::atomic<bool>     _cancelled;
+    // a worker threw, which stops the others
+    std::atomic<bool>     _failed;
+    // set while requestMove is pending
+    ResumeFn _resume;
+    // a search is queued or running, the pool may be shared so its wait()
+    // does not tell; guarded by _searchMutex, with the first error of a
+    // worker, which a pending move resumes with
+    std::mutex _searchMutex;
+    std::condition_variable _searchDone;
+    bool _running;
+    std::exception_ptr _error;
+
+    // searches on the pool and waits; true with _combo set to play
+    bool _search(const GameState* state);
+    // sets up the search of state; true if none is needed (forced play or
+    // no play), with play telling whether _combo holds a play
+    bool _beginSearch(const GameState* state, bool& play);
+    void _startWorkers(void);
+    // blocks until no search is queued or running
+    void _waitSearch(void);
+    // merges the trees of the workers; true with _combo set to play
+    bool _endSearch(void);
+    // the chosen play, its cards leaving the hand, or a pass
+    const Combo& _takeMove(const bool play);
+
+    void _runWorker(Worker* worker);
+    void _iterate(Worker& worker, const GameState& state, const Position& root,
+                  const CardSet& unseen);
+    uint32_t _addChild(Worker& worker, const uint32_t parent,
+                       const Combo& move, const uint8_t player);
+
+    static bool _isSameMove(const Combo& a, const Combo& b);
+    static bool _isLegal(const Combo& move, const Position& pos);
+    static void _playMove(Position& pos, const Combo& move);
+
+    static const uint32_t sNoNode = 0xFFFFFFFF;
+};
+
+} /* namespace pusoydos */
+
+#endif
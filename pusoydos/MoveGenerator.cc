@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "ComboClassifier.h"
+#include "MoveGenerator.h"
+
+namespace pusoydos {
+
+const uint16_t MoveGenerator::sMaxHandSize;
+const uint16_t MoveGenerator::sMaxMoves;
+const uint8_t MoveGenerator::sStartingCard;
+
+static bool
+compareByKey(const ComboClassifier::Result& a, const ComboClassifier::Result& b)
+{
+    return (a.key < b.key);
+}
+
+uint16_t
+MoveGenerator::generate(const CardSet& hand, const GameState& state,
+                        Combo* moves, const uint16_t maxMoves)
+{
+    return generate(hand, state.combo, state.firstCombo, moves, maxMoves);
+}
+
+bool
+MoveGenerator::_addMove(const Combo::ComboT type, const CardSet& cards,
+                        const uint32_t key, const Combo& toBeat,
+                        const bool firstCombo,
+                        Combo* moves, uint16_t& numMoves, const uint16_t maxMoves)
+{
+    if (firstCombo && !cards.has(sStartingCard)) {
+        return true;
+    }
+    // keys order types first, so a higher five-card type always beats
+    if (toBeat.getSize() > 0 && key <= toBeat.getKey()) {
+        return true;
+    }
+    if (numMoves == maxMoves) {
+        return false;
+    }
+    Combo& move = moves[numMoves++];
+    move.resetAll();
+    move._assign(type, cards, key);
+    return true;
+}
+
+uint16_t
+MoveGenerator::generate(const CardSet& hand, const Combo& toBeat,
+                        const bool firstCombo,
+                        Combo* moves, const uint16_t maxMoves)
+{
+    uint16_t numMoves = 0;
+    Combo::ComboT beatType = (toBeat.getSize() > 0) ? toBeat.getType() : Combo::kUndef;
+    bool leading = (beatType == Combo::kUndef);
+
+    // singles, keys ascend with card codes
+    if (leading || beatType == Combo::kSingle) {
+        for (CardSet::MaskT m = hand.getMask(); m; m &= m - 1) {
+            uint8_t code = __builtin_ctzll(m);
+            CardSet cards;
+            cards.add(code);
+            uint32_t key = ((uint32_t)(Combo::kSingle + 1) << 24) | code;
+            if (!_addMove(Combo::kSingle, cards, key, toBeat, firstCombo,
+                          moves, numMoves, maxMoves)) {
+                return numMoves;
+            }
+        }
+    }
+
+    // pairs and three-of-a-kinds, ordered by their highest card
+    for (uint16_t n = 2; n <= 3; ++n) {
+        Combo::ComboT type = (n == 2) ? Combo::kPair : Combo::kThreeKind;
+        if (!leading && beatType != type) {
+            continue;
+        }
+        for (uint16_t rank = 0; rank < CardSet::sNumRanks; ++rank) {
+            CardSet rankCards = hand.getRankCards(rank);
+            if (rankCards.size() < n) {
+                continue;
+            }
+            for (uint16_t high = 0; high < CardSet::sNumSuits; ++high) {
+                uint8_t highCode = CardSet::makeCode(rank, high);
+                if (!rankCards.has(highCode)) {
+                    continue;
+                }
+                // lower cards of the rank
+                CardSet::MaskT lower = rankCards.getMask() & (CardSet::getBit(highCode) - 1);
+                uint32_t key = ((uint32_t)(type + 1) << 24) | highCode;
+                for (CardSet::MaskT a = lower; a; a &= a - 1) {
+                    CardSet::MaskT aBit = a & -a;
+                    if (n == 2) {
+                        if (!_addMove(type, CardSet(aBit | CardSet::getBit(highCode)), key,
+                                      toBeat, firstCombo, moves, numMoves, maxMoves)) {
+                            return numMoves;
+                        }
+                        continue;
+                    }
+                    for (CardSet::MaskT b = a & (a - 1); b; b &= b - 1) {
+                        CardSet::MaskT bBit = b & -b;
+                        if (!_addMove(type, CardSet(aBit | bBit | CardSet::getBit(highCode)), key,
+                                      toBeat, firstCombo, moves, numMoves, maxMoves)) {
+                            return numMoves;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // five-card combos
+    if (hand.size() >= Combo::sMaxComboSize &&
+        (leading || beatType >= Combo::kStraight)) {
+        ComboClassifier::Result results[ComboClassifier::sMaxFiveCardSubsets];
+        uint16_t numResults = ComboClassifier::classifyAll(hand, results,
+                                                           ComboClassifier::sMaxFiveCardSubsets);
+        // keys group by type, then order by strength
+        std::sort(results, results + numResults, compareByKey);
+        for (uint16_t i = 0; i < numResults; ++i) {
+            if (!_addMove(results[i].type, results[i].cards, results[i].key,
+                          toBeat, firstCombo, moves, numMoves, maxMoves)) {
+                return numMoves;
+            }
+        }
+    }
+    return numMoves;
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,51 @@
+#ifndef _PUSOYDOS_MOVEGENERATOR_H_
+#define _PUSOYDOS_MOVEGENERATOR_H_
+
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+#include "GameState.h"
+
+namespace pusoydos {
+
+// generates every legal play of a hand against the game state into a
+// caller-provided buffer, without allocating. Plays are grouped by combo
+// type (ascending) and ordered by ascending strength key within a type.
+// Leading (state combo empty) allows any combo, and the first lead of a set
+// must contain the 3 of clubs. Following requires the same type for
+// singles, pairs and three-of-a-kinds, and any five-card combo of the same
+// or a higher type that beats the current one. Passing is not included.
+class MoveGenerator
+{
+  public:
+    static uint16_t generate(const CardSet& hand, const GameState& state,
+                             Combo* moves, const uint16_t maxMoves);
+
+    static uint16_t generate(const CardSet& hand, const Combo& toBeat,
+                             const bool firstCombo,
+                             Combo* moves, const uint16_t maxMoves);
+
+    // largest hand whose plays all fit sMaxMoves; Game seats no player that
+    // lists its plays at a larger hand (a 2-player 26-card hand has
+    // C(26,5) = 65780 five-card sets)
+    static const uint16_t sMaxHandSize = 13;
+
+    // enough room for every play of a 13-card hand
+    // (13 singles + 78 pairs + 286 three-of-a-kinds + 1287 five-card sets)
+    static const uint16_t sMaxMoves = 1664;
+
+    // 3 of clubs, the lowest card, must be part of the first lead
+    static const uint8_t sStartingCard = 0;
+
+  private:
+    static bool _addMove(const Combo::ComboT type, const CardSet& cards,
+                         const uint32_t key, const Combo& toBeat,
+                         const bool firstCombo,
+                         Combo* moves, uint16_t& numMoves, const uint16_t maxMoves);
+};
+
+} /* namespace pusoydos */
+
+#endif
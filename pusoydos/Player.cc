@@ -1,20 +1,27 @@
 #include <algorithm>
 #include <stdexcept>
+#include <exception>
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdlib.h>
 
 #include "Player.h"
+#include "MctsPlayer.h"
+#include "MoveGenerator.h"
+#include "Stats.h"
 
 using namespace game;
 
 namespace pusoydos {
 
 Player::Player(void)
-    : _name(""), _hand(), _combo()
+    : _name(""), _seat(0), _rules(&Rules::standard()), _hand(), _combo()
 {
 }
 
 Player::Player(const std::string name)
-    : _name(name), _hand(name), _combo(name)
+    : _name(name), _seat(0), _rules(&Rules::standard()), _hand(), _combo()
 {
 }
 
@@ -34,47 +41,173 @@ Player::getName(void) const
     return _name;
 }
 
+void
+Player::setRules(const Rules* rules)
+{
+    _rules = rules;
+}
+
+void
+Player::setSeat(const uint8_t seat)
+{
+    _seat = seat;
+    _combo.setOwner(seat);
+}
+
+uint8_t
+Player::getSeat(void) const
+{
+    return _seat;
+}
+
 void
 Player::dealCard(CardPtr card)
 {
-    _hand.addCard(card);
+    CardSet added(CardSet::getBit(_rules->getCardCode(*card)));
+    _hand.add(added);
+    _onHandChanged(added, CardSet());
+}
+
+void
+Player::setHand(const CardSet& hand)
+{
+    CardSet old = _hand;
+    _hand = hand;
+    _onHandChanged(hand - old, old - hand);
 }
 
 bool
 Player::hasCard(const uint16_t value, const char suit)
 {
-    uint16_t index;
-    _hand.findCard(value, suit, index);
-    return (index != _hand.getHandSize());
+    if (value < 2 || value > 10) {
+        return false;
+    }
+    return _hand.has(_rules->getCardCode(value, suit));
 }
 
 bool
 Player::hasCard(const char face, const char suit)
 {
-    uint16_t index;
-    _hand.findCard(face, suit, index);
-    return (index != _hand.getHandSize());
+    return _hand.has(_rules->getCardCode(face, suit));
 }
 
 uint16_t
 Player::cardsLeft(void) const
 {
-    return _hand.getHandSize();
+    return _hand.size();
+}
+
+const CardSet&
+Player::getCards(void) const
+{
+    return _hand;
+}
+
+bool
+Player::requestMove(const GameState* state, Combo& move, const ResumeFn& resume)
+{
+    if (state->leadPlayer == _seat) {
+        move = playLeadCombo(state);
+        return true;
+    }
+    move.resetAll();
+    move.setOwner(_seat);
+    if (!playFollowCombo(state, move)) {
+        move.resetAll();
+        move.setOwner(_seat);
+    }
+    return true;
+}
+
+void
+Player::waitForMove(void)
+{
+}
+
+void
+Player::cancelMove(void)
+{
+}
+
+bool
+Player::listsPlays(void) const
+{
+    return false;
 }
 
 void
 Player::reset(void)
 {
-    _hand.reset();
+    CardSet old = _hand;
+    _hand.clear();
+    _onHandChanged(CardSet(), old);
     _combo.resetCards();
+    _arena.reset();
+}
+
+void
+Player::seedRandom(const uint64_t seed, const uint64_t gameId)
+{
+    _rng = RandomStream(seed, gameId, RandomStream::getSeatStream(_seat));
 }
 
 void
-Player::printHand(std::ostream& os)
+Player::printHand(std::ostream& os) const
 {
     os << _name << ": ";
-    _hand.sort();
-    _hand.printToStream(os);
+    for (uint16_t i = 0; i < _hand.size(); ++i) {
+        // right-align each card under its index column
+        std::ostringstream oss;
+        _rules->getCard(_hand.nth(i))->printToStream(oss);
+        os << std::setw(5) << oss.str();
+    }
+}
+
+Player *
+Player::createPlayer(const std::string& type, const std::string& name)
+{
+    if (type == "human") {
+        return new HumanPlayer(name);
+    }
+    else if (type == "cpu") {
+        return new CpuPlayer(name);
+    }
+    else if (type.compare(0, 4, "cpu:") == 0) {
+        char* end = NULL;
+        unsigned long cards = strtoul(type.c_str() + 4, &end, 10);
+        if (end == type.c_str() + 4 || (*end != '\0' && *end != ':') ||
+            cards > EndgameSolver::sMaxCards) {
+            throw std::invalid_argument("invalid cpu player type: " + type);
+        }
+        unsigned long long nodes = CpuPlayer::sDefaultEndgameNodes;
+        if (*end == ':') {
+            const char* start = end + 1;
+            nodes = strtoull(start, &end, 10);
+            if (end == start || *end != '\0' || nodes == 0) {
+                throw std::invalid_argument("invalid cpu player type: " + type);
+            }
+        }
+        return new CpuPlayer(name, cards, nodes);
+    }
+    else if (type == "remote") {
+        return new RemotePlayer(name);
+    }
+    else if (type.compare(0, 6, "ismcts") == 0) {
+        return new MctsPlayer(name, MctsPlayer::Budget::parse(type));
+    }
+    throw std::invalid_argument("unknown player type: " + type);
+}
+
+void
+Player::_removeCards(const CardSet& cards)
+{
+    _hand.remove(cards);
+    _onHandChanged(CardSet(), cards);
+}
+
+void
+Player::_onHandChanged(const CardSet& added, const CardSet& removed)
+{
 }
 
 
@@ -82,43 +215,155 @@ Player::printHand(std::ostream& os)
  ******************* CpuPlayer **********************
  ****************************************************/
 
+const uint16_t CpuPlayer::sEndgameSamples;
+const uint64_t CpuPlayer::sDefaultEndgameNodes;
+
 CpuPlayer::CpuPlayer(void)
-    : Player()
+    : Player(),
+      _straightStarts(0),
+      _endgameCards(0),
+      _endgameNodes(sDefaultEndgameNodes),
+      _solver(NULL),
+      _pool(NULL),
+      _deciding(false),
+      _cancelled(false)
 {
+    std::fill(_countRanks, _countRanks + 4, 0);
+}
+
+CpuPlayer::CpuPlayer(const std::string name, const uint16_t endgameCards,
+                     const uint64_t endgameNodes)
+    : Player(name),
+      _straightStarts(0),
+      _endgameCards(endgameCards),
+      _endgameNodes(endgameNodes),
+      _solver(NULL),
+      _pool(NULL),
+      _deciding(false),
+      _cancelled(false)
+{
+    std::fill(_countRanks, _countRanks + 4, 0);
 }
 
-CpuPlayer::CpuPlayer(const std::string name)
-    : Player(name)
+CpuPlayer::~CpuPlayer(void)
 {
+    cancelMove();
 }
 
-CpuPlayer::~CpuPlayer(void)
+void
+CpuPlayer::reset(void)
+{
+    if (_ownSolver) {
+        _ownSolver->clear();
+    }
+    Player::reset();
+}
+
+void
+CpuPlayer::setEndgameSolver(EndgameSolver* solver)
+{
+    _ownSolver.reset();
+    _solver = solver;
+}
+
+void
+CpuPlayer::setDecisionPool(ThreadPool* pool)
 {
+    _pool = pool;
+}
+
+bool
+CpuPlayer::requestMove(const GameState* state, Combo& move, const ResumeFn& resume)
+{
+    // only a solve takes long enough to be worth a thread hop
+    if (!_pool || !_isEndgame(state)) {
+        return Player::requestMove(state, move, resume);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_decisionMutex);
+        _deciding = true;
+        _cancelled = false;
+    }
+    _pool->submit([this, state, resume] { _decide(state, resume); });
+    return false;
+}
+
+void
+CpuPlayer::waitForMove(void)
+{
+    std::unique_lock<std::mutex> lock(_decisionMutex);
+    _decisionDone.wait(lock, [this] { return !_deciding; });
+}
+
+void
+CpuPlayer::cancelMove(void)
+{
+    std::unique_lock<std::mutex> lock(_decisionMutex);
+    _cancelled = true;
+    _decisionDone.wait(lock, [this] { return !_deciding; });
+}
+
+void
+CpuPlayer::_decide(const GameState* state, const ResumeFn& resume)
+{
+    Combo move;
+    std::exception_ptr error;
+    try {
+        Player::requestMove(state, move, resume);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    // resumes under the lock, so the player cannot be destroyed (see
+    // cancelMove) before the resume has returned
+    std::unique_lock<std::mutex> lock(_decisionMutex);
+    std::exception_ptr failure;
+    if (!_cancelled) {
+        try {
+            resume(move, error);
+        }
+        catch (...) {
+            // the driver broke, nobody but the pool is left to tell
+            failure = std::current_exception();
+        }
+    }
+    _deciding = false;
+    _decisionDone.notify_all();
+    lock.unlock();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
 }
 
 const Combo&
 CpuPlayer::playLeadCombo(const GameState* state)
 {
-    if (_hand.getHandSize() == 0) {
+    if (_hand.empty()) {
         throw std::runtime_error("player has no more cards");
     }
     _combo.resetCards();
-    uint16_t index = 0;
 
     if (state->firstCombo) {
         // must lead with 3c
-        _hand.findCard((uint16_t)3, Card::Clubs, index);
-        if (index != _hand.getHandSize()) {
+        uint8_t code = _rules->getCardCode((uint16_t)3, Card::Clubs);
+        if (_hand.has(code)) {
             _combo.setType(Combo::kSingle);
-            _combo.addCard(_hand.playCard(index));
+            _combo.addCard(code);
+            _removeCards(_combo.getCardSet());
         }
         else {
             throw std::runtime_error("player does not have 3 of clubs");
         }
     }
     else {
-        // find best combo to lead with
-        _findCombo(state->combo, true);
+        bool play;
+        if (_solveEndgame(state, play)) {
+            _removeCards(_combo.getCardSet());
+        }
+        else {
+            // find best combo to lead with
+            _findCombo(state->combo, true);
+        }
     }
     return _combo;
 }
@@ -126,103 +371,162 @@ CpuPlayer::playLeadCombo(const GameState* state)
 void
 CpuPlayer::_findCombo(const Combo& curCombo, bool leader)
 {
-    _updateCardCounts();
-    _updateStraights();
+    PUSOYDOS_STATS_TIME(Stats::kFindComboTime);
     // ordered by descending combo rank
     if (_tryFourOfKind(curCombo, leader)) return;
     if (_tryFullHouse(curCombo, leader)) return;
     if (_tryStraight(curCombo, leader)) return;
     if (_tryThreeOfKind(curCombo, leader)) return;
     if (_tryPair(curCombo, leader)) return;
-    if (_trySingle(curCombo, leader) == false) {
-        throw std::runtime_error("player has no more cards");
+    if (_trySingle(curCombo, leader)) return;
+    if (leader && !_hand.empty()) {
+        // only a lone four-of-a-kind is left (no kicker), lead lowest card
+        uint8_t code = _hand.lowest();
+        _combo.setType(Combo::kSingle);
+        _combo.resetCards();
+        _combo.addCard(code);
+        _removeCards(_combo.getCardSet());
+        return;
     }
+    throw std::runtime_error("player has no more cards");
 }
 
-void
-CpuPlayer::_updateCardCounts(void)
+bool
+CpuPlayer::_isEndgame(const GameState* state) const
+{
+    uint16_t numCards = 0;
+    for (uint16_t i = 0; i < state->numPlayers; ++i) {
+        // the solver lists plays, which waits for small enough hands
+        if (state->cardsLeft[i] > MoveGenerator::sMaxHandSize) {
+            return false;
+        }
+        numCards += state->cardsLeft[i];
+    }
+    return (!state->firstCombo && numCards <= _endgameCards);
+}
+
+bool
+CpuPlayer::_solveEndgame(const GameState* state, bool& play)
 {
-    _cardCounts.clear();
-    for (uint16_t idx = 0; idx < _hand.getHandSize(); ++idx) {
-        const CardPtr& card = _hand.checkCard(idx);
-        _cardCounts[card->getValue()].push_back(idx);
+    if (!_isEndgame(state)) {
+        return false;
     }
+    PUSOYDOS_STATS_TIME(Stats::kEndgameTime);
+    PUSOYDOS_STATS_COUNT(Stats::kEndgameSolves);
 
-    _valSets.clear();
-    _valSets.resize(4);
-    for (CardCountMap::iterator it = _cardCounts.begin();
-         it != _cardCounts.end(); ++it) {
-        // index into array (map value) is card count (index vector size) minus 1
-        // vector element is card value
-        _valSets[it->second.size()-1].push_back(it->first);
+    if (!_solver) {
+        _ownSolver.reset(new EndgameSolver());
+        _solver = _ownSolver.get();
     }
-/*
-for (uint16_t i = 0; i < _valSets.size(); ++i) {
- for (uint16_t j = 0; j < _valSets[i].size(); ++j) {
-  std::cerr << "valSets[" << i << "][" << j << "] = " << _valSets[i][j] << std::endl;
- }
-}
-*/
+    CardSet hands[GameState::sMaxPlayers];
+    hands[_seat] = _hand;
+    Position root(*state, _seat, hands);
+    CardSet unseen = Position::getUnseen(*state, _hand);
+    // against a single opponent the deal is known and one solve is exact
+    uint16_t numSamples = (root.numPlayers == 2) ? 1 : sEndgameSamples;
+
+    Combo moves[sEndgameSamples];
+    uint16_t votes[sEndgameSamples];
+    uint16_t numMoves = 0;
+    uint64_t nodesLeft = _endgameNodes;
+    for (uint16_t n = 0; n < numSamples && nodesLeft > 0; ++n) {
+        Position pos = root;
+        pos.dealHidden(*state, _seat, unseen, _rng);
+        EndgameSolver::Result result =
+            _solver->solve(pos, std::min(nodesLeft, EndgameSolver::sDefaultMaxNodes));
+        nodesLeft -= std::min(nodesLeft, result.nodes);
+        if (!result.solved || !result.win) {
+            continue;
+        }
+        uint16_t m = 0;
+        while (m < numMoves && !(moves[m].getCardSet() == result.move.getCardSet() &&
+                                 moves[m].getType() == result.move.getType())) {
+            ++m;
+        }
+        if (m == numMoves) {
+            moves[numMoves] = result.move;
+            votes[numMoves++] = 0;
+        }
+        ++votes[m];
+    }
+    if (numMoves == 0) {
+        return false;
+    }
+
+    uint16_t best = 0;
+    for (uint16_t m = 1; m < numMoves; ++m) {
+        if (votes[m] > votes[best]) {
+            best = m;
+        }
+    }
+    play = (moves[best].getSize() != 0);
+    if (play) {
+        _combo = moves[best];
+        _combo.setOwner(_seat);
+    }
+    return true;
 }
 
 void
-CpuPlayer::_updateStraights(void)
+CpuPlayer::_onHandChanged(const CardSet& added, const CardSet& removed)
 {
-    _hand.sort();
-    _straights.clear();
-    uint16_t idx = 0;
-    uint16_t straightStart = _hand.checkCard(idx++)->getValue();
-    uint16_t straightCur = straightStart;
-    for (; idx < _hand.getHandSize(); ++idx) {
-        const CardPtr& card = _hand.checkCard(idx);
-        uint16_t value = card->getValue();
-        // check for continuous values (ascending order)
-        if (value == (straightCur+1)) {
-            straightCur++;
-        }
-        else if (value != straightCur) {
-            straightStart = value;
-        }
-        if ((straightCur - straightStart + 1) == 5) {
-            // store start and end values
-            std::pair<uint16_t, uint16_t> interval(straightStart, straightCur);
-            _straights.push_back(interval);
-            // slide interval in case other straights contain the last 4 cards
-            straightStart++;
+    // only the ranks of the cards that came or went change count class
+    uint16_t touched = (added | removed).getRankMask();
+    for (uint16_t count = kSingle; count <= kFour; ++count) {
+        _countRanks[count] &= ~touched;
+    }
+    for (; touched; touched &= touched - 1) {
+        uint16_t rank = __builtin_ctz(touched);
+        uint16_t count = _hand.getRankCount(rank);
+        if (count > 0) {
+            _countRanks[count-1] |= 1 << rank;
         }
     }
-/*
-for (uint16_t i = 0; i < _straights.size(); ++i) {
- std::cerr << "straights[" << i << "]=(" << _straights[i].first << ", " << _straights[i].second << ")\n";
+    uint16_t ranks = _countRanks[kSingle] | _countRanks[kPair] |
+                     _countRanks[kThree] | _countRanks[kFour];
+    _straightStarts = ranks & (ranks >> 1) & (ranks >> 2) & (ranks >> 3) & (ranks >> 4);
 }
-*/
+
+bool
+CpuPlayer::_tryRanks(uint16_t ranks, const Combo& curCombo, bool leader)
+{
+    // ranks in ascending order, the combo takes every card held of a rank
+    for (; ranks; ranks &= ranks - 1) {
+        _combo.setCards(_hand.getRankCards(__builtin_ctz(ranks)));
+        if (leader || !(_combo < curCombo)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool
 CpuPlayer::_tryStraight(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t straightIdx = 0;
-    std::vector<uint16_t> indices;
-    if (_straights.size() > 0) {
+    PUSOYDOS_STATS_TIME(Stats::kTryStraightTime);
+    uint16_t starts = _straightStarts;
+    CardSet cards;
+    if (starts) {
         _combo.setType(Combo::kStraight);
         do {
             _combo.resetCards();
-            indices.clear();
-            for (uint16_t val = _straights[straightIdx].first;
-                 val < (_straights[straightIdx].first+5); ++val) {
-                // TODO: use lowest suit of card if more than one
-                if ((index = _hand.findCardIndexByValue(val)) == _hand.getHandSize()) {
+            cards.clear();
+            uint16_t straightStart = __builtin_ctz(starts);
+            for (uint16_t rank = straightStart; rank <= straightStart + 4; ++rank) {
+                CardSet rankCards = _hand.getRankCards(rank);
+                if (rankCards.empty()) {
                     throw std::runtime_error("expected to find a straight but failed");
                 }
-                _combo.addCard(_hand.checkCard(index));
-                indices.push_back(index);
+                // use lowest suit of rank
+                uint8_t code = rankCards.lowest();
+                _combo.addCard(code);
+                cards.add(code);
             }
         }
-        while (!leader && (_combo < curCombo) && (++straightIdx < _straights.size()));
+        while (!leader && (_combo < curCombo) && (starts &= starts - 1));
 
-        if (straightIdx < _straights.size()) {
-            _hand.playCards(indices);
+        if (starts) {
+            _removeCards(cards);
             return true;
         }
     }
@@ -232,36 +536,23 @@ CpuPlayer::_tryStraight(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::_tryFourOfKind(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t fourIdx = 0;
-    std::vector<uint16_t> indices;
+    PUSOYDOS_STATS_TIME(Stats::kTryFourKindTime);
     // check for four-of-a-kind
-    if (!_valSets[kFour].empty()) {
-        _combo.setType(Combo::kFourKind);
-        // sort pairs in ascending order by value
-        std::sort(_valSets[kFour].begin(), _valSets[kFour].end());
-        do {
-            _combo.resetCards();
-            indices.clear();
-            uint16_t fourValue = _valSets[kFour][fourIdx];
-            for (uint16_t n = 0; n < 4; ++n) {
-                if ((index = _cardCounts[fourValue][n]) >= _hand.getHandSize()) {
-                    throw std::runtime_error("expected to find four of a kind but failed");
-                }
-                _combo.addCard(_hand.checkCard(index));
-                indices.push_back(index);
-            }
-        }
-        while (!leader && (_combo < curCombo) && (++fourIdx < _valSets[kFour].size()));
-
-        if (fourIdx < _valSets[kFour].size()) {
-            // combo already created, just play out (remove) cards from hand
-            _hand.playCards(indices);
-            // use lowest single  // TODO: make sure non-pair card
-            _hand.getLowestCard(index);
-            _combo.addCard(_hand.playCard(index));
-            return true;
+    _combo.setType(Combo::kFourKind);
+    if (_tryRanks(_countRanks[kFour], curCombo, leader)) {
+        CardSet cards = _combo.getCardSet();
+        CardSet rest = _hand - cards;
+        if (rest.empty()) {
+            // no card left for the fifth card
+            return false;
         }
+        // combo already created, just play out (remove) cards from hand
+        // use lowest single  // TODO: make sure non-pair card
+        uint8_t code = rest.lowest();
+        _combo.addCard(code);
+        cards.add(code);
+        _removeCards(cards);
+        return true;
     }
     return false;
 }
@@ -269,47 +560,23 @@ CpuPlayer::_tryFourOfKind(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::_tryFullHouse(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t threeIdx = 0;
-    std::vector<uint16_t> indices;
+    PUSOYDOS_STATS_TIME(Stats::kTryFullHouseTime);
     // check for three of a kind
-    if (!_valSets[kThree].empty() &&
-        !_valSets[kPair].empty()) {
-        _combo.setType(Combo::kFullHouse);
-        // sort three of kinds in ascending order by value
-        std::sort(_valSets[kThree].begin(), _valSets[kThree].end());
-        do {
-            _combo.resetCards();
-            indices.clear();
-            uint16_t threeValue = _valSets[kThree][threeIdx];
-            for (uint16_t n = 0; n < 3; ++n) {
-                if ((index = _cardCounts[threeValue][n]) >= _hand.getHandSize()) {
-                    throw std::runtime_error("expected to find three of a kind but failed");
-                }
-                _combo.addCard(_hand.checkCard(index));
-                indices.push_back(index);
-            }
-        }
-        while (!leader && (_combo < curCombo) && (++threeIdx < _valSets[kThree].size()));
-        // warning: assumes operator< only compares triple (and not whole hand)
-
-        if (threeIdx < _valSets[kThree].size()) {
-            // combo already has three-of-kind, just play out (remove) cards from hand
-            _hand.playCards(indices);
-
-            // re-calculate indices and sort pairs in ascending order
-            _updateCardCounts();
-            std::sort(_valSets[kPair].begin(), _valSets[kPair].end());
-            // use lowest pair
-            uint16_t pairIdx = 0;
-            for (uint16_t n = 0; n < 2; ++n) {
-                if ((index = _hand.findCardIndexByValue(_valSets[kPair][pairIdx])) == _hand.getHandSize()) {
-                    throw std::runtime_error("expected to find pair but failed");
-                }
-                _combo.addCard(_hand.playCard(index));
-            }
-            return true;
-        }
+    if (_countRanks[kPair] == 0) {
+        return false;
+    }
+    _combo.setType(Combo::kFullHouse);
+    // warning: assumes operator< only compares triple (and not whole hand)
+    if (_tryRanks(_countRanks[kThree], curCombo, leader)) {
+        // use lowest pair; the triple's rank is not among the pairs
+        CardSet cards = _combo.getCardSet();
+        CardSet pair = _hand.getRankCards(__builtin_ctz(_countRanks[kPair]));
+        for (CardSet::MaskT m = pair.getMask(); m; m &= m - 1) {
+            _combo.addCard(__builtin_ctzll(m));
+        }
+        cards.add(pair);
+        _removeCards(cards);
+        return true;
     }
     return false;
 }
@@ -317,33 +584,13 @@ CpuPlayer::_tryFullHouse(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::_tryThreeOfKind(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t threeIdx = 0;
-    std::vector<uint16_t> indices;
+    PUSOYDOS_STATS_TIME(Stats::kTryThreeKindTime);
     // check for three of kinds
-    if (!_valSets[kThree].empty()) {
-        _combo.setType(Combo::kThreeKind);
-        // sort pairs in ascending order by value
-        std::sort(_valSets[kThree].begin(), _valSets[kThree].end());
-        do {
-            _combo.resetCards();
-            indices.clear();
-            uint16_t threeValue = _valSets[kThree][threeIdx];
-            for (uint16_t n = 0; n < 3; ++n) {
-                if ((index = _cardCounts[threeValue][n]) >= _hand.getHandSize()) {
-                    throw std::runtime_error("expected to find three of a kind but failed");
-                }
-                _combo.addCard(_hand.checkCard(index));
-                indices.push_back(index);
-            }
-        }
-        while (!leader && (_combo < curCombo) && (++threeIdx < _valSets[kThree].size()));
-
-        if (threeIdx < _valSets[kThree].size()) {
-            // combo already created, just play out (remove) cards from hand
-            _hand.playCards(indices);
-            return true;
-        }
+    _combo.setType(Combo::kThreeKind);
+    if (_tryRanks(_countRanks[kThree], curCombo, leader)) {
+        // combo already created, just play out (remove) cards from hand
+        _removeCards(_combo.getCardSet());
+        return true;
     }
     return false;
 }
@@ -351,33 +598,13 @@ CpuPlayer::_tryThreeOfKind(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::_tryPair(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t pairIdx = 0;
-    std::vector<uint16_t> indices;
+    PUSOYDOS_STATS_TIME(Stats::kTryPairTime);
     // check for pairs
-    if (!_valSets[kPair].empty()) {
-        _combo.setType(Combo::kPair);
-        // sort pairs in ascending order by value
-        std::sort(_valSets[kPair].begin(), _valSets[kPair].end());
-        do {
-            _combo.resetCards();
-            indices.clear();
-            uint16_t pairValue = _valSets[kPair][pairIdx];
-            for (uint16_t n = 0; n < 2; ++n) {
-                if ((index = _cardCounts[pairValue][n]) >= _hand.getHandSize()) {
-                    throw std::runtime_error("expected to find pair but failed");
-                }
-                _combo.addCard(_hand.checkCard(index));
-                indices.push_back(index);
-            }
-        }
-        while (!leader && (_combo < curCombo) && (++pairIdx < _valSets[kPair].size()));
-
-        if (pairIdx < _valSets[kPair].size()) {
-            // combo already created, just play out (remove) cards from hand
-            _hand.playCards(indices);
-            return true;
-        }
+    _combo.setType(Combo::kPair);
+    if (_tryRanks(_countRanks[kPair], curCombo, leader)) {
+        // combo already created, just play out (remove) cards from hand
+        _removeCards(_combo.getCardSet());
+        return true;
     }
     return false;
 }
@@ -385,26 +612,13 @@ CpuPlayer::_tryPair(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::_trySingle(const Combo& curCombo, bool leader)
 {
-    uint16_t index = 0;
-    uint16_t singleIdx = 0;
-    if (!_valSets[kSingle].empty()) {
-        _combo.setType(Combo::kSingle);
-        // use lowest possible card
-        std::sort(_valSets[kSingle].begin(), _valSets[kSingle].end());
-        do {
-            _combo.resetCards();
-            if ((index = _hand.findCardIndexByValue(_valSets[kSingle][singleIdx])) == _hand.getHandSize()) {
-                throw std::runtime_error("expected to find single but failed");
-            }
-            _combo.addCard(_hand.checkCard(index));
-        }
-        while (!leader && (_combo < curCombo) && (++singleIdx < _valSets[kSingle].size()));
-
-        if (singleIdx < _valSets[kSingle].size()) {
-            // combo already created, just play out (remove) card from hand
-            _hand.playCard(index);
-            return true;
-        }
+    PUSOYDOS_STATS_TIME(Stats::kTrySingleTime);
+    // use lowest possible card, a rank held once is its only card
+    _combo.setType(Combo::kSingle);
+    if (_tryRanks(_countRanks[kSingle], curCombo, leader)) {
+        // combo already created, just play out (remove) card from hand
+        _removeCards(_combo.getCardSet());
+        return true;
     }
     return false;
 }
@@ -412,13 +626,19 @@ CpuPlayer::_trySingle(const Combo& curCombo, bool leader)
 bool
 CpuPlayer::playFollowCombo(const GameState* state, Combo& combo)
 {
-    if (_hand.getHandSize() == 0) {
+    if (_hand.empty()) {
         return false;
     }
     combo.resetAll();
-    combo.setOwner(_name);
-    if (state->combo.getType() != Combo::kStraight) {
-        _updateCardCounts();
+    combo.setOwner(_seat);
+    bool play;
+    if (_solveEndgame(state, play)) {
+        if (!play) {
+            return false;
+        }
+        _removeCards(_combo.getCardSet());
+        combo = _combo;
+        return true;
     }
     switch (state->combo.getType()) {
       case Combo::kSingle:
@@ -442,7 +662,6 @@ CpuPlayer::playFollowCombo(const GameState* state, Combo& combo)
       case Combo::kStraight:
       case Combo::kFullHouse:
       case Combo::kFourKind:
-        _updateStraights();
         if (_tryStraight(state->combo, false)) {
             combo = _combo;
             return true;
@@ -471,12 +690,18 @@ CpuPlayer::playFollowCombo(const GameState* state, Combo& combo)
  ****************************************************/
 
 HumanPlayer::HumanPlayer(void)
-    : Player()
+    : Player(),
+      _step(kIdle),
+      _state(NULL),
+      _numCards(0)
 {
 }
 
 HumanPlayer::HumanPlayer(const std::string name)
-    : Player(name)
+    : Player(name),
+      _step(kIdle),
+      _state(NULL),
+      _numCards(0)
 {
 }
 
@@ -487,122 +712,177 @@ HumanPlayer::~HumanPlayer(void)
 const Combo&
 HumanPlayer::playLeadCombo(const GameState* state)
 {
-    printComboTypes(std::cerr);
-    int type;
-    uint16_t numCards = 0;
-    while (true) {
-        std::cerr << "\nindices:    0    1    2    3    4    5    6    7    8    9   10   11   12\n";
-        printHand(std::cerr);
-        printf("\nEnter combo type to lead with: ");
-        scanf("%d", &type);
-        if (type < 0 || type > Combo::NUMTYPES) {
-            printf("Invalid combo type.\n");
-            continue;
-        }
-        _combo.resetAll();
-        _combo.setOwner(_name);
-        _combo.setType((Combo::ComboT)type);
-        if ((numCards = Combo::getNumCardsInCombo((Combo::ComboT)type)) == 0) {
-            printf("Invalid combo type.\n");
-            continue;
-        }
-        std::vector<CardPtr> cardsToPlay;
-        while (cardsToPlay.size() < numCards) {
-            int index;
-            while (true) {
-                printf("\nEnter card index to play [%lu]: ", cardsToPlay.size()+1);
-                scanf("%d", &index);
-                if (index < 0 || index > _hand.getHandSize()-1) {
-                    printf("Invalid index.\n");
-                    continue;
-                }
-                break;
-            }
-            if (_combo.addCard(_hand.checkCard(index))) {
-                cardsToPlay.push_back(CardPtr(new Card(*(_hand.checkCard(index)))));
-            }
-        }
-        for (uint16_t i = 0; i < cardsToPlay.size(); ++i) {
-            uint16_t index;
-            if (cardsToPlay[i]->isFaceCard()) {
-                _hand.findCard(cardsToPlay[i]->getFace(), cardsToPlay[i]->getSuit(), index);
-            }
-            else {
-                _hand.findCard(cardsToPlay[i]->getValue(), cardsToPlay[i]->getSuit(), index);
-            }
-            _hand.playCard(index);
-        }
-        break;
-    } /* end while */
-    
+    Combo move;
+    requestMove(state, move, [&move](const Combo& decided, const std::exception_ptr&) { move = decided; });
+    waitForMove();
+    _combo = move;
     return _combo;
 }
 
 bool
 HumanPlayer::playFollowCombo(const GameState* state, Combo& combo)
 {
+    Combo move;
+    requestMove(state, move, [&move](const Combo& decided, const std::exception_ptr&) { move = decided; });
+    waitForMove();
+    if (move.getSize() == 0) {
+        return false;
+    }
+    combo = move;
+    return true;
+}
+
+bool
+HumanPlayer::requestMove(const GameState* state, Combo& move, const ResumeFn& resume)
+{
+    _state = state;
+    _resume = resume;
     printComboTypes(std::cerr);
-    int pass = -1;
-    int type;
-    uint16_t numCards = 0;
-    while (true) {
-        std::cerr << "\nindices:    0    1    2    3    4    5    6    7    8    9   10   11   12\n";
-        printHand(std::cerr);
-        printf("\nPass (0) or play (1)? ");
-        scanf("%d", &pass);
-        if (pass != 0 && pass != 1) {
+    _restart();
+    return false;
+}
+
+void
+HumanPlayer::waitForMove(void)
+{
+    while (_step != kIdle) {
+        int answer;
+        if (scanf("%d", &answer) != 1) {
+            if (feof(stdin)) {
+                throw std::runtime_error("end of input while waiting for a move");
+            }
+            // skip what is not a number
+            scanf("%*s");
             continue;
         }
-        if (pass == 0) {
-            return false;
+        input(answer);
+    }
+}
+
+void
+HumanPlayer::cancelMove(void)
+{
+    _step = kIdle;
+    _resume = nullptr;
+}
+
+bool
+HumanPlayer::isWaiting(void) const
+{
+    return (_step != kIdle);
+}
+
+void
+HumanPlayer::input(const int answer)
+{
+    bool leading = (_state->leadPlayer == _seat);
+    switch (_step) {
+      case kIdle:
+        return;
+
+      case kPassOrPlay:
+        if (answer != 0 && answer != 1) {
+            _restart();
+        }
+        else if (answer == 0) {
+            Combo pass;
+            pass.setOwner(_seat);
+            _finish(pass);
         }
-        printf("\nEnter combo type to follow: ");
-        scanf("%d", &type);
-        if (type < 0 || type > Combo::NUMTYPES) {
+        else {
+            printf("\nEnter combo type to follow: ");
+            _step = kComboType;
+        }
+        return;
+
+      case kComboType:
+        if (answer < 0 || answer > Combo::NUMTYPES) {
             printf("Invalid combo type.\n");
-            continue;
+            _restart();
+            return;
         }
-        if (state->combo.getType() < Combo::kStraight && type != state->combo.getType()) {
+        if (!leading && _state->combo.getType() < Combo::kStraight &&
+            answer != _state->combo.getType()) {
             printf("Must follow combo type for non-five-card combos.\n");
-            continue;
+            _restart();
+            return;
         }
-        if (type < state->combo.getType()) {
+        if (!leading && answer < _state->combo.getType()) {
             printf("Must be able to meet or beat current combo type.\n");
-            continue;
+            _restart();
+            return;
         }
         _combo.resetAll();
-        _combo.setOwner(_name);
-        _combo.setType((Combo::ComboT)type);
-        if ((numCards = Combo::getNumCardsInCombo((Combo::ComboT)type)) == 0) {
+        _combo.setOwner(_seat);
+        _combo.setType((Combo::ComboT)answer);
+        if ((_numCards = Combo::getNumCardsInCombo((Combo::ComboT)answer)) == 0) {
             printf("Invalid combo type.\n");
-            continue;
-        }
-        std::vector<uint16_t> indices;
-        while (indices.size() < numCards) {
-            int index;
-            while (true) {
-                printf("\nEnter card index to play [%lu]: ", indices.size()+1);//cardsToPlay.size()+1);
-                scanf("%d", &index);
-                if (index < 0 || index > _hand.getHandSize()-1) {
-                    printf("Invalid index.\n");
-                    continue;
-                }
-                break;
-            }
-            if (_combo.addCard(_hand.checkCard(index))) {
-                indices.push_back(index);
+            _restart();
+            return;
+        }
+        _picked.clear();
+        _step = kCardIndex;
+        _promptCard();
+        return;
+
+      case kCardIndex:
+        if (answer < 0 || answer >= _hand.size() ||
+            _picked.has(_hand.nth(answer))) {
+            printf("Invalid index.\n");
+            _promptCard();
+            return;
+        }
+        {
+            uint8_t code = _hand.nth(answer);
+            if (_combo.addCard(code)) {
+                _picked.add(code);
             }
         }
-        if (type == state->combo.getType() && _combo < state->combo) {
+        if (_picked.size() < _numCards) {
+            _promptCard();
+            return;
+        }
+        if (!leading && _combo.getType() == _state->combo.getType() &&
+            _combo < _state->combo) {
             printf("Combo does not beat current combo.\n");
             _combo.resetAll();
-            continue;
+            _restart();
+            return;
         }
-        _hand.playCards(indices);
-        combo = _combo;
-        break;
-    } /* end while */
-    return true;
+        _removeCards(_picked);
+        _finish(_combo);
+        return;
+    }
+}
+
+void
+HumanPlayer::_restart(void)
+{
+    std::cerr << "\nindices:    0    1    2    3    4    5    6    7    8    9   10   11   12\n";
+    printHand(std::cerr);
+    if (_state->leadPlayer == _seat) {
+        printf("\nEnter combo type to lead with: ");
+        _step = kComboType;
+    }
+    else {
+        printf("\nPass (0) or play (1)? ");
+        _step = kPassOrPlay;
+    }
+}
+
+void
+HumanPlayer::_promptCard(void)
+{
+    printf("\nEnter card index to play [%d]: ", _picked.size()+1);
+}
+
+void
+HumanPlayer::_finish(const Combo& move)
+{
+    _step = kIdle;
+    ResumeFn resume;
+    resume.swap(_resume);
+    resume(move, std::exception_ptr());
 }
 
 void
@@ -621,4 +901,86 @@ HumanPlayer::printComboTypes(std::ostream& os) const
        << "=======================\n\n";
 }
 
+/****************************************************
+ ****************** RemotePlayer ********************
+ ****************************************************/
+
+RemotePlayer::RemotePlayer(void)
+    : Player()
+{
+}
+
+RemotePlayer::RemotePlayer(const std::string name)
+    : Player(name)
+{
+}
+
+RemotePlayer::~RemotePlayer(void)
+{
+}
+
+const Combo&
+RemotePlayer::playLeadCombo(const GameState* state)
+{
+    throw std::logic_error("remote player " + _name + " cannot decide synchronously");
+}
+
+bool
+RemotePlayer::playFollowCombo(const GameState* state, Combo& combo)
+{
+    throw std::logic_error("remote player " + _name + " cannot decide synchronously");
+}
+
+bool
+RemotePlayer::requestMove(const GameState* state, Combo& move, const ResumeFn& resume)
+{
+    _resume = resume;
+    return false;
+}
+
+void
+RemotePlayer::waitForMove(void)
+{
+    throw std::logic_error("remote player " + _name + " cannot be waited for");
+}
+
+void
+RemotePlayer::cancelMove(void)
+{
+    _resume = nullptr;
+}
+
+bool
+RemotePlayer::listsPlays(void) const
+{
+    return true;
+}
+
+void
+RemotePlayer::setMove(const Combo& move)
+{
+    if (!_resume) {
+        throw std::logic_error("remote player " + _name + " was not asked to move");
+    }
+    Combo played = move;
+    played.setOwner(_seat);
+    _removeCards(played.getCardSet());
+    ResumeFn resume;
+    resume.swap(_resume);
+    resume(played, std::exception_ptr());
+}
+
+bool
+RemotePlayer::isWaiting(void) const
+{
+    return (bool)_resume;
+}
+
+void
+RemotePlayer::reset(void)
+{
+    _resume = nullptr;
+    Player::reset();
+}
+
 } /* namespace pusoydos */
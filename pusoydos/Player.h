@@ -1,13 +1,24 @@
 #ifndef _PUSOYDOS_PLAYER_H_
 #define _PUSOYDOS_PLAYER_H_
 
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
 // game
 #include "Card.h"
-#include "Hand.h"
 
 // pusoydos
+#include "Arena.h"
+#include "CardSet.h"
 #include "Combo.h"
 #include "GameState.h"
+#include "EndgameSolver.h"
+#include "Random.h"
+#include "ThreadPool.h"
 
 using namespace game;
 
@@ -24,24 +35,86 @@ class Player
     void setName(const std::string name);
     const std::string& getName(void) const;
 
+    // rules context of the game the player is seated at
+    void setRules(const Rules* rules);
+
+    void setSeat(const uint8_t seat);
+    uint8_t getSeat(void) const;
+
     void dealCard(CardPtr card);
+    // replaces the hand with a whole dealt hand
+    void setHand(const CardSet& hand);
 
     bool hasCard(const uint16_t value, const char suit);
     bool hasCard(const char face, const char suit);
 
+    // synchronous decision: the combo to lead with / false to pass or the
+    // combo that beats state->combo; the cards leave the hand
     virtual const Combo& playLeadCombo(const GameState* state) = 0;
     virtual bool playFollowCombo(const GameState* state, Combo& combo) = 0;
 
+    // continuation of a pending decision, called with the move (an empty
+    // combo to pass) whose cards have left the hand, or with the error of
+    // a decision that failed (move then means nothing)
+    typedef std::function<void(const Combo& move, const std::exception_ptr& error)> ResumeFn;
+
+    // non-blocking decision (see Game::requestMove): asks for the move of
+    // the seat's turn in state, a lead if the seat holds the lead. Returns
+    // true with move set if the player decided at once; otherwise the
+    // decision is pending and the player calls resume once it has decided,
+    // possibly from another thread, unless the request is cancelled first.
+    // state must not change while the decision is pending. The default
+    // decides at once with playLeadCombo / playFollowCombo.
+    virtual bool requestMove(const GameState* state, Combo& move, const ResumeFn& resume);
+    // blocks until the pending decision has resumed, for drivers that have
+    // nothing else to do meanwhile (the console game)
+    virtual void waitForMove(void);
+    // drops the pending decision, resume is not called afterwards
+    virtual void cancelMove(void);
+
+    // the player lists every play of its hand (see MoveGenerator), so it
+    // can only be dealt hands of at most MoveGenerator::sMaxHandSize cards
+    virtual bool listsPlays(void) const;
+
     uint16_t cardsLeft(void) const;
+    const CardSet& getCards(void) const;
 
-    void reset(void);
+    // ends the player's game: drops the hand and recycles the game arena
+    virtual void reset(void);
 
-    void printHand(std::ostream& os);
+    // points the player's randomness at its seat stream of the given game
+    // (see RandomStream); called on every deal
+    virtual void seedRandom(const uint64_t seed, const uint64_t gameId);
+
+    void printHand(std::ostream& os) const;
+
+    // creates player of given type ("human", "cpu" without endgame solver,
+    // "cpu:<endgame cards>[:<nodes>]" (see CpuPlayer), "remote" or an
+    // "ismcts" spec, see
+    // MctsPlayer::Budget::parse)
+    static Player * createPlayer(const std::string& type, const std::string& name);
 
   protected:
+    // plays cards out of the hand
+    void _removeCards(const CardSet& cards);
+    // called after every change of the hand (setHand, dealCard,
+    // _removeCards, reset) with the cards that came and went, for players
+    // that follow the hand incrementally
+    virtual void _onHandChanged(const CardSet& added, const CardSet& removed);
+
     std::string  _name;
-    Hand<Combo::CompareCards> _hand;
+    uint8_t      _seat;
+    const Rules *_rules;
+    // cards held, ascending card codes are the sorted hand
+    CardSet      _hand;
     Combo _combo;
+    // all sampling and tie-breaking of the player draws from this
+    RandomStream _rng;
+    // storage that lives for one game, recycled by reset(); only the
+    // ISMCTS root merge needs it, the other per-game storage (hand
+    // analysis, endgame move lists, search trees) is fixed size or keeps
+    // its capacity from game to game
+    Arena        _arena;
 
 };
 
@@ -49,34 +122,68 @@ class CpuPlayer : public Player
 {
   public:
     CpuPlayer(void);
-    CpuPlayer(const std::string name);
+    // hands over to the endgame solver once at most endgameCards cards are
+    // left in the set (0, the default, never does: about 1000 times faster
+    // and weaker in the endgame), searching at most endgameNodes nodes over
+    // all the deals of one move, which bounds its latency
+    CpuPlayer(const std::string name,
+              const uint16_t endgameCards = 0,
+              const uint64_t endgameNodes = sDefaultEndgameNodes);
 
     ~CpuPlayer(void);
 
     virtual const Combo& playLeadCombo(const GameState* state);
     virtual bool playFollowCombo(const GameState* state, Combo& combo);
 
+    // also clears the player's own endgame solver, so a game is played the
+    // same whatever games came before it
+    virtual void reset(void);
+
+    // solves endgames with solver (not owned, NULL for a solver of the
+    // player's own, created on its first endgame); players driven by one
+    // thread, e.g. the tables of a server loop, can share one solver and
+    // its transposition table, which its owner clears (see
+    // EndgameSolver::clear)
+    void setEndgameSolver(EndgameSolver* solver);
+
+    // decides the moves that take an endgame solve on pool (not owned, NULL
+    // to decide on the calling thread): requestMove then returns at once
+    // and the decision resumes from a worker of the pool. The endgame
+    // solver is then only used from the pool, so players that share one
+    // must share a single-thread pool too
+    void setDecisionPool(ThreadPool* pool);
+
+    virtual bool requestMove(const GameState* state, Combo& move, const ResumeFn& resume);
+    virtual void waitForMove(void);
+    // waits for a decision already running on the pool, which then does
+    // not resume
+    virtual void cancelMove(void);
+
+    // deals of the unseen cards solved per endgame move
+    static const uint16_t sEndgameSamples = 8;
+    // every deal may use the solver's own node limit
+    static const uint64_t sDefaultEndgameNodes = sEndgameSamples * EndgameSolver::sDefaultMaxNodes;
 
   private:
-    // [card value, card count]
-    typedef std::map<uint16_t, std::vector<uint16_t> > CardCountMap;
-    CardCountMap _cardCounts;
+    // times the hand analysis directly (see pusoydosbench.cc)
+    friend class CpuPlayerBench;
 
     typedef enum {
-        kSingle = 0, // valSets[0] = singles
-        kPair   = 1, // valSets[1] = pairs
-        kThree  = 2, // valSets[2] = three of kind
-        kFour   = 3  // valSets[3] = four of kind
+        kSingle = 0, // countRanks[0] = singles
+        kPair   = 1, // countRanks[1] = pairs
+        kThree  = 2, // countRanks[2] = three of kind
+        kFour   = 3  // countRanks[3] = four of kind
     } CountT;
 
-    // valSets[0] = [(val0) (val1) ... ]
-    std::vector<std::vector<uint16_t> > _valSets;
+    // analysis of the hand, kept up to date card by card (see
+    // _onHandChanged) so a decision does not rescan the hand:
+    // countRanks[count] has bit r set if rank r is held exactly count+1
+    // times
+    uint16_t _countRanks[4];
+    // bit r set if ranks r .. r+4 are all held
+    uint16_t _straightStarts;
 
-    // [(startVal0, endVal0) (startVal1, endval1) ... ]
-    std::vector<std::pair<uint16_t, uint16_t> > _straights;
-
-    void _updateCardCounts(void);
-    void _updateStraights(void);
+    virtual void _onHandChanged(const CardSet& added, const CardSet& removed);
 
     void _findCombo(const Combo& curCombo, bool leader);
 
@@ -86,9 +193,38 @@ class CpuPlayer : public Player
     bool _tryThreeOfKind(const Combo& curCombo, bool leader);
     bool _tryPair(const Combo& curCombo, bool leader);
     bool _trySingle(const Combo& curCombo, bool leader);
-
+    // sets the combo, of the type already set, to the cards of the lowest
+    // rank in ranks that beats curCombo (any rank if leader); false if none
+    bool _tryRanks(uint16_t ranks, const Combo& curCombo, bool leader);
+
+    // once few cards are left, hands over to the endgame solver: sampled
+    // deals of the unseen cards are solved and the play that wins the most
+    // of them is chosen (play false to pass); false if no deal is won
+    bool _solveEndgame(const GameState* state, bool& play);
+    // few enough cards are left for the endgame solver
+    bool _isEndgame(const GameState* state) const;
+    // decides at once on a pool worker and resumes, with the error if the
+    // decision throws
+    void _decide(const GameState* state, const ResumeFn& resume);
+
+    uint16_t _endgameCards;
+    uint64_t _endgameNodes;
+    std::unique_ptr<EndgameSolver> _ownSolver;
+    EndgameSolver* _solver;
+
+    ThreadPool* _pool;
+    // a decision is queued or running on the pool; guarded by
+    // _decisionMutex, which a worker holds while it resumes
+    std::mutex  _decisionMutex;
+    std::condition_variable _decisionDone;
+    bool        _deciding;
+    bool        _cancelled;
 };
 
+// console player: a decision is a short dialogue (pass or play, combo
+// type, one card index per card) kept as a resumable state machine that
+// input() advances one answer at a time; waitForMove reads the answers
+// from stdin
 class HumanPlayer : public Player
 {
   public:
@@ -100,7 +236,70 @@ class HumanPlayer : public Player
     virtual const Combo& playLeadCombo(const GameState* state);
     virtual bool playFollowCombo(const GameState* state, Combo& combo);
 
+    // prompts for the first answer, the decision is always pending
+    virtual bool requestMove(const GameState* state, Combo& move, const ResumeFn& resume);
+    virtual void waitForMove(void);
+    virtual void cancelMove(void);
+
+    // next answer of the pending decision; prompts for the one after it or
+    // resumes the decision
+    void input(const int answer);
+    bool isWaiting(void) const;
+
     void printComboTypes(std::ostream& os) const;
+
+  private:
+    typedef enum {
+        kIdle       = 0,
+        kPassOrPlay = 1,
+        kComboType  = 2,
+        kCardIndex  = 3
+    } StepT;
+
+    StepT            _step;
+    const GameState* _state;
+    ResumeFn         _resume;
+    // cards of the combo picked so far, and how many it takes
+    CardSet          _picked;
+    uint16_t         _numCards;
+
+    // asks the first question again
+    void _restart(void);
+    void _promptCard(void);
+    void _finish(const Combo& move);
+};
+
+// seat played from outside the game, e.g. by a client of a table server
+// (see Table): a requested move stays pending until it is handed over with
+// setMove, and is not checked here
+class RemotePlayer : public Player
+{
+  public:
+    RemotePlayer(void);
+    RemotePlayer(const std::string name);
+
+    ~RemotePlayer(void);
+
+    // the synchronous decisions cannot be answered, the seat is only
+    // played through requestMove
+    virtual const Combo& playLeadCombo(const GameState* state);
+    virtual bool playFollowCombo(const GameState* state, Combo& combo);
+
+    // always pending until setMove
+    virtual bool requestMove(const GameState* state, Combo& move, const ResumeFn& resume);
+    virtual void waitForMove(void);
+    virtual void cancelMove(void);
+    // the table checks the client's plays against the list
+    virtual bool listsPlays(void) const;
+
+    // resumes the pending decision with move, an empty combo to pass
+    void setMove(const Combo& move);
+    bool isWaiting(void) const;
+
+    virtual void reset(void);
+
+  private:
+    ResumeFn _resume;
 };
 
 } /* namespace pusoydos */
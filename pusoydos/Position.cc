@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "MoveGenerator.h"
+#include "Position.h"
+#include "Zobrist.h"
+
+namespace pusoydos {
+
+Position::Position(void)
+    : numPlayers(GameState::sMaxPlayers),
+      toMove(0),
+      leader(0),
+      firstCombo(false)
+{
+    key = computeKey();
+}
+
+Position::Position(const GameState& state, const uint8_t seat, const CardSet* hands)
+    : combo(state.combo),
+      numPlayers(state.numPlayers),
+      toMove(seat),
+      leader(state.leadPlayer),
+      firstCombo(state.firstCombo)
+{
+    if (numPlayers > GameState::sMaxPlayers) {
+        throw std::invalid_argument("too many players for search position");
+    }
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        this->hands[i] = hands[i];
+    }
+    if (toMove == leader) {
+        // leader starts a new round
+        combo.resetAll();
+    }
+    key = computeKey();
+}
+
+uint16_t
+Position::generateMoves(Combo* moves, const uint16_t maxMoves) const
+{
+    return MoveGenerator::generate(hands[toMove], combo, firstCombo, moves, maxMoves);
+}
+
+void
+Position::play(const Combo& move)
+{
+    CardSet cards = move.getCardSet();
+    hands[toMove].remove(cards);
+    key ^= Zobrist::getHandKey(toMove, cards) ^
+           Zobrist::getComboKey(combo) ^ Zobrist::getComboKey(move) ^
+           Zobrist::getLeaderKey(leader) ^ Zobrist::getLeaderKey(toMove);
+    if (firstCombo) {
+        key ^= Zobrist::getFirstComboKey();
+    }
+    combo = move;
+    combo.setOwner(toMove);
+    leader = toMove;
+    firstCombo = false;
+    if (!hands[toMove].empty()) {
+        _advance();
+    }
+}
+
+void
+Position::pass(void)
+{
+    _advance();
+    if (toMove == leader) {
+        // all other players passed, leader starts a new round
+        key ^= Zobrist::getComboKey(combo);
+        combo.resetAll();
+    }
+}
+
+void
+Position::_advance(void)
+{
+    uint8_t next = (toMove + 1 == numPlayers) ? 0 : toMove + 1;
+    key ^= Zobrist::getToMoveKey(toMove) ^ Zobrist::getToMoveKey(next);
+    toMove = next;
+}
+
+bool
+Position::canPass(void) const
+{
+    return !isLeading();
+}
+
+bool
+Position::isLeading(void) const
+{
+    return (combo.getSize() == 0);
+}
+
+bool
+Position::isTerminal(void) const
+{
+    return hands[toMove].empty();
+}
+
+uint8_t
+Position::getWinner(void) const
+{
+    return toMove;
+}
+
+uint16_t
+Position::getNumCards(void) const
+{
+    uint16_t numCards = 0;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        numCards += hands[i].size();
+    }
+    return numCards;
+}
+
+uint64_t
+Position::computeKey(void) const
+{
+    uint64_t k = Zobrist::getComboKey(combo) ^
+                 Zobrist::getLeaderKey(leader) ^ Zobrist::getToMoveKey(toMove);
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        k ^= Zobrist::getHandKey(i, hands[i]);
+    }
+    if (firstCombo) {
+        k ^= Zobrist::getFirstComboKey();
+    }
+    return k;
+}
+
+void
+Position::dealHidden(const GameState& state, const uint8_t observer,
+                     const CardSet& unseen, RandomStream& rng)
+{
+    uint8_t codes[CardSet::sNumCards];
+    uint16_t numCodes = 0;
+    for (CardSet::MaskT m = unseen.getMask(); m; m &= m - 1) {
+        codes[numCodes++] = __builtin_ctzll(m);
+    }
+    uint16_t numHidden = 0;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        if (i != observer) {
+            numHidden += state.cardsLeft[i];
+        }
+    }
+    if (numHidden != numCodes) {
+        throw std::logic_error("hand sizes in game state do not match unseen cards");
+    }
+    for (uint16_t i = numCodes; i > 1; --i) {
+        std::swap(codes[i-1], codes[rng.below(i)]);
+    }
+    uint16_t next = 0;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        if (i == observer) {
+            continue;
+        }
+        hands[i].clear();
+        for (uint16_t k = 0; k < state.cardsLeft[i]; ++k) {
+            hands[i].add(codes[next++]);
+        }
+    }
+    key = computeKey();
+}
+
+CardSet
+Position::getUnseen(const GameState& state, const CardSet& hand)
+{
+    return CardSet(CardSet::sFullMask) - hand - state.played;
+}
+
+} /* namespace pusoydos */
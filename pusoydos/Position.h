@@ -0,0 +1,70 @@
+#ifndef _PUSOYDOS_POSITION_H_
+#define _PUSOYDOS_POSITION_H_
+
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+#include "GameState.h"
+#include "Random.h"
+
+namespace pusoydos {
+
+// compact copy of a set in progress with every hand known, used by search.
+// Follows Game::playRound: the leader plays any combo, the others play a
+// higher combo or pass, and once play comes back around to the leader (the
+// last player to play) a new round starts with an empty combo. Fields may
+// be set directly, after which key must be recomputed.
+class Position
+{
+  public:
+    Position(void);
+
+    // position at a decision of seat, with hands given for all seats
+    Position(const GameState& state, const uint8_t seat, const CardSet* hands);
+
+    // legal plays for the player to move (passing not included)
+    uint16_t generateMoves(Combo* moves, const uint16_t maxMoves) const;
+
+    // player to move plays combo (cards must be in their hand)
+    void play(const Combo& combo);
+    // player to move passes, precondition: canPass()
+    void pass(void);
+
+    bool canPass(void) const;
+    bool isLeading(void) const;
+    bool isTerminal(void) const;
+    // seat that ran out of cards, precondition: isTerminal()
+    uint8_t getWinner(void) const;
+
+    uint16_t getNumCards(void) const;
+
+    // Zobrist key of the position built from scratch; key holds the same
+    // value, kept up to date by play() and pass()
+    uint64_t computeKey(void) const;
+
+    // deals unseen cards at random to every seat but observer, at the hand
+    // sizes in state; throws if those do not add up to the unseen cards
+    void dealHidden(const GameState& state, const uint8_t observer,
+                    const CardSet& unseen, RandomStream& rng);
+
+    // cards neither in hand nor played so far, hidden from the hand's owner
+    static CardSet getUnseen(const GameState& state, const CardSet& hand);
+
+    CardSet  hands[GameState::sMaxPlayers];
+    Combo    combo;
+    uint8_t  numPlayers;
+    uint8_t  toMove;
+    uint8_t  leader;
+    bool     firstCombo;
+    uint64_t key;
+
+  private:
+    // passes the turn to the next seat
+    void _advance(void);
+};
+
+} /* namespace pusoydos */
+
+#endif
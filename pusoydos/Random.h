@@ -0,0 +1,102 @@
+#ifndef _PUSOYDOS_RANDOM_H_
+#define _PUSOYDOS_RANDOM_H_
+
+#include <stdint.h>
+
+namespace pusoydos {
+
+// counter-based random stream (Philox4x32-10): draw n of a stream is a pure
+// function of (experiment seed, game id, stream id, n), so any game of a
+// sharded experiment can be re-run on its own and results do not depend on
+// how games are spread over threads, processes or machines. Each game has
+// one stream for the deal and one per seat (sub-streams for e.g. search
+// workers). Meets the UniformRandomBitGenerator requirements.
+class RandomStream
+{
+  public:
+    typedef uint64_t result_type;
+
+    explicit RandomStream(const uint64_t seed = 0, const uint64_t gameId = 0,
+                          const uint32_t streamId = 0)
+        : _key{ (uint32_t)seed, (uint32_t)(seed >> 32) },
+          _counter{ 0, streamId, (uint32_t)gameId, (uint32_t)(gameId >> 32) },
+          _next(sBlockSize)
+    {
+    }
+
+    uint32_t next32(void)
+    {
+        if (_next == sBlockSize) {
+            _generate();
+        }
+        return _block[_next++];
+    }
+
+    uint64_t operator()(void)
+    {
+        uint64_t hi = next32();
+        return (hi << 32) | next32();
+    }
+
+    // uniform in [0, bound), bound > 0; multiply-shift with rejection of
+    // the few values that would bias the result (Lemire)
+    uint32_t below(const uint32_t bound)
+    {
+        uint64_t m = (uint64_t)next32() * bound;
+        if ((uint32_t)m < bound) {
+            const uint32_t threshold = -bound % bound;
+            while ((uint32_t)m < threshold) {
+                m = (uint64_t)next32() * bound;
+            }
+        }
+        return m >> 32;
+    }
+
+    static constexpr uint64_t min(void) { return 0; }
+    static constexpr uint64_t max(void) { return ~0ULL; }
+
+    static const uint32_t sDealStream = 0;
+
+    // stream of a seat, sub 0 for the player itself, others for helpers
+    static uint32_t getSeatStream(const uint8_t seat, const uint16_t sub = 0)
+    {
+        return ((uint32_t)(seat + 1) << 16) | sub;
+    }
+
+  private:
+    static const uint16_t sBlockSize = 4;
+
+    uint32_t _key[2];
+    // block index, stream id, game id (low, high)
+    uint32_t _counter[4];
+    uint32_t _block[sBlockSize];
+    uint16_t _next;
+
+    void _generate(void)
+    {
+        uint32_t c[4] = { _counter[0], _counter[1], _counter[2], _counter[3] };
+        uint32_t k0 = _key[0];
+        uint32_t k1 = _key[1];
+        for (uint16_t round = 0; round < 10; ++round) {
+            uint64_t p0 = (uint64_t)0xD2511F53 * c[0];
+            uint64_t p1 = (uint64_t)0xCD9E8D57 * c[2];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c[1] ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c[3] ^ k1;
+            c[0] = n0;
+            c[1] = (uint32_t)p1;
+            c[2] = n2;
+            c[3] = (uint32_t)p0;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        for (uint16_t i = 0; i < sBlockSize; ++i) {
+            _block[i] = c[i];
+        }
+        ++_counter[0];
+        _next = 0;
+    }
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,221 @@
+#include <string>
+#include <stdexcept>
+
+#include "Game.h"
+#include "MoveGenerator.h"
+#include "Replay.h"
+
+namespace pusoydos {
+
+namespace {
+
+std::runtime_error
+turnError(const uint16_t turn, const std::string& what)
+{
+    return std::runtime_error("replay turn " + std::to_string(turn) + ": " + what);
+}
+
+} /* anonymous namespace */
+
+Replay::Replay(const uint16_t numPlayers, const CardSet* hands,
+               const uint64_t* turns, const uint16_t numTurns)
+    : _turns(turns, turns + numTurns),
+      _turn(0),
+      _finished(false),
+      _winner(0),
+      _points(0)
+{
+    _build(numPlayers, hands);
+}
+
+Replay::Replay(const GameRecordReader::RecordView& record)
+    : _turns(record.turns, record.turns + record.header->numTurns),
+      _turn(0),
+      _finished(false),
+      _winner(0),
+      _points(0)
+{
+    CardSet hands[GameState::sMaxPlayers];
+    for (uint16_t i = 0; i < record.header->numPlayers; ++i) {
+        hands[i] = CardSet(record.header->hands[i]);
+    }
+    _build(record.header->numPlayers, hands);
+}
+
+Replay
+Replay::fromSeed(const uint64_t seed, const uint64_t index,
+                 const uint16_t numPlayers,
+                 const uint64_t* turns, const uint16_t numTurns)
+{
+    CardSet hands[GameState::sMaxPlayers];
+    Game::dealHands(seed, index, numPlayers, hands);
+    return Replay(numPlayers, hands, turns, numTurns);
+}
+
+void
+Replay::_build(const uint16_t numPlayers, const CardSet* hands)
+{
+    if (numPlayers == 0 || numPlayers > GameState::sMaxPlayers) {
+        throw std::invalid_argument("invalid number of players for replay");
+    }
+    Snapshot snap;
+    snap.state.numPlayers = numPlayers;
+    snap.state.firstCombo = true;
+    bool dealt = false;
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        snap.hands[i] = hands[i];
+        snap.state.cardsLeft[i] = hands[i].size();
+        if (hands[i].has(MoveGenerator::sStartingCard)) {
+            // holder of the 3 of clubs leads first
+            snap.state.leadPlayer = i;
+            dealt = true;
+        }
+    }
+    if (!dealt) {
+        throw std::invalid_argument("no player holds the 3 of clubs");
+    }
+
+    _snapshots.reserve(_turns.size() + 1);
+    _snapshots.push_back(snap);
+    uint8_t toMove = snap.state.leadPlayer;
+    for (uint16_t t = 0; t < _turns.size(); ++t) {
+        if (_finished) {
+            throw turnError(t, "turn after the set ended");
+        }
+        GameState& state = snap.state;
+        uint8_t seat = GameRecord::getTurnSeat(_turns[t]);
+        if (seat != toMove) {
+            throw turnError(t, "played out of turn");
+        }
+        Combo combo = GameRecord::decodeTurn(_turns[t]);
+        bool leading = (seat == state.leadPlayer);
+        if (combo.getSize() == 0) {
+            if (leading) {
+                throw turnError(t, "leader passed");
+            }
+        }
+        else {
+            CardSet cards = combo.getCardSet();
+            if (!snap.hands[seat].contains(cards)) {
+                throw turnError(t, "cards not in hand");
+            }
+            // singles, pairs and three-of-a-kinds share one rank
+            if (combo.getKey() == 0 ||
+                combo.getSize() != Combo::getNumCardsInCombo(combo.getType()) ||
+                (combo.getSize() < Combo::sMaxComboSize &&
+                 __builtin_popcount(cards.getRankMask()) != 1)) {
+                throw turnError(t, "not a valid combo");
+            }
+            if (state.firstCombo && !cards.has(MoveGenerator::sStartingCard)) {
+                throw turnError(t, "first combo without the 3 of clubs");
+            }
+            // keys order combos of one size, five-card types included
+            if (!leading && (combo.getSize() != state.combo.getSize() ||
+                             combo.getKey() <= state.combo.getKey())) {
+                throw turnError(t, "combo does not beat the current combo");
+            }
+            snap.hands[seat].remove(cards);
+            state.cardsLeft[seat] = snap.hands[seat].size();
+            state.played.add(cards);
+            state.combo = combo;
+            state.leadPlayer = seat;
+            state.firstCombo = false;
+            if (snap.hands[seat].empty()) {
+                _finished = true;
+                _winner = seat;
+                _points = Game::getSetPoints(combo);
+            }
+        }
+        toMove = (toMove + 1 == numPlayers) ? 0 : toMove + 1;
+        if (toMove == state.leadPlayer) {
+            // everyone else passed, the leader starts a new round
+            state.combo.resetAll();
+        }
+        _snapshots.push_back(snap);
+    }
+}
+
+uint16_t
+Replay::getNumTurns(void) const
+{
+    return _turns.size();
+}
+
+uint16_t
+Replay::getTurn(void) const
+{
+    return _turn;
+}
+
+void
+Replay::seek(const uint16_t turn)
+{
+    if (turn > _turns.size()) {
+        throw std::out_of_range("replay turn out of range");
+    }
+    _turn = turn;
+}
+
+bool
+Replay::stepForward(void)
+{
+    if (_turn == _turns.size()) {
+        return false;
+    }
+    ++_turn;
+    return true;
+}
+
+bool
+Replay::stepBack(void)
+{
+    if (_turn == 0) {
+        return false;
+    }
+    --_turn;
+    return true;
+}
+
+const GameState&
+Replay::getState(void) const
+{
+    return _snapshots[_turn].state;
+}
+
+const CardSet&
+Replay::getHand(const uint8_t seat) const
+{
+    return _snapshots[_turn].hands[seat];
+}
+
+uint64_t
+Replay::getNextTurn(void) const
+{
+    return _turns.at(_turn);
+}
+
+bool
+Replay::isFinished(void) const
+{
+    return _finished;
+}
+
+uint8_t
+Replay::getWinner(void) const
+{
+    return _winner;
+}
+
+uint16_t
+Replay::getPoints(void) const
+{
+    return _points;
+}
+
+bool
+Replay::matches(const GameRecord::Header& header) const
+{
+    return (_finished && header.winner == _winner && header.points == _points);
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,77 @@
+#ifndef _PUSOYDOS_REPLAY_H_
+#define _PUSOYDOS_REPLAY_H_
+
+#include <vector>
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "GameState.h"
+#include "GameRecord.h"
+
+namespace pusoydos {
+
+// rebuilds a set from its deal and its turns (see GameRecord) without any
+// player logic. Every turn is checked against the rules of Game::playRound
+// once, on construction, and the game state before each turn is kept, so
+// seeking to any turn and stepping either way are constant time.
+class Replay
+{
+  public:
+    // throws std::runtime_error naming the turn if the turns are not a
+    // legal set for the deal
+    Replay(const uint16_t numPlayers, const CardSet* hands,
+           const uint64_t* turns, const uint16_t numTurns);
+    explicit Replay(const GameRecordReader::RecordView& record);
+
+    // replay of deal index for seed (see Game::dealHands)
+    static Replay fromSeed(const uint64_t seed, const uint64_t index,
+                           const uint16_t numPlayers,
+                           const uint64_t* turns, const uint16_t numTurns);
+
+    uint16_t getNumTurns(void) const;
+    // turns applied so far, 0 at the deal
+    uint16_t getTurn(void) const;
+
+    // state after the first turn turns, precondition: turn <= getNumTurns()
+    void seek(const uint16_t turn);
+    // false at the end / start
+    bool stepForward(void);
+    bool stepBack(void);
+
+    // state before the next turn, as Game holds it
+    const GameState& getState(void) const;
+    const CardSet& getHand(const uint8_t seat) const;
+    // next turn to replay, precondition: getTurn() < getNumTurns()
+    uint64_t getNextTurn(void) const;
+
+    // a player went out with the last turn
+    bool isFinished(void) const;
+    // precondition: isFinished()
+    uint8_t getWinner(void) const;
+    uint16_t getPoints(void) const;
+
+    // the turns finish the set with the winner and points of the record
+    bool matches(const GameRecord::Header& header) const;
+
+  private:
+    class Snapshot
+    {
+      public:
+        GameState state;
+        CardSet   hands[GameState::sMaxPlayers];
+    };
+
+    std::vector<uint64_t> _turns;
+    std::vector<Snapshot> _snapshots;
+    uint16_t _turn;
+    bool     _finished;
+    uint8_t  _winner;
+    uint16_t _points;
+
+    void _build(const uint16_t numPlayers, const CardSet* hands);
+};
+
+} /* namespace pusoydos */
+
+#endif
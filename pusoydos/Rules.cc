@@ -0,0 +1,203 @@
+#include <string>
+#include <stdexcept>
+
+#include "Rules.h"
+
+namespace pusoydos {
+
+Rules::Rules(void)
+{
+    _suitList[Card::Clubs] = 1;
+    _suitList[Card::Spades] = 2;
+    _suitList[Card::Hearts] = 3;
+    _suitList[Card::Diamonds] = 4;
+    _buildCardTable();
+}
+
+void
+Rules::setSuitRank(const char suit, const uint16_t rank)
+{
+    if (rank < 1 || rank > CardSet::sNumSuits) {
+        throw std::invalid_argument("suit rank out of range");
+    }
+    SuitList::iterator it = _suitList.find(suit);
+    if (it == _suitList.end() || it->second != rank) {
+        _suitList[suit] = rank;
+        _buildCardTable();
+    }
+}
+
+uint16_t
+Rules::getSuitRank(const char suit) const
+{
+    SuitList::const_iterator it = _suitList.find(suit);
+    if (it == _suitList.end()) {
+        throw std::invalid_argument("unknown suit");
+    }
+    return it->second;
+}
+
+const SuitList&
+Rules::getSuitList(void) const
+{
+    return _suitList;
+}
+
+uint16_t
+Rules::_getSuitIndex(const char suit) const
+{
+    return getSuitRank(suit) - 1;
+}
+
+void
+Rules::_buildCardTable(void)
+{
+    for (SuitList::const_iterator suitIt = _suitList.begin();
+         suitIt != _suitList.end(); ++suitIt) {
+        uint16_t suitIdx = suitIt->second - 1;
+        for (uint16_t rank = 0; rank < CardSet::sNumRanks; ++rank) {
+            _cards[CardSet::makeCode(rank, suitIdx)] = getInternedCard(rank, suitIt->first);
+        }
+    }
+}
+
+uint8_t
+Rules::getCardCode(const Card& card) const
+{
+    return CardSet::makeCode(getRankOfValue(card.getValue()), _getSuitIndex(card.getSuit()));
+}
+
+uint8_t
+Rules::getCardCode(const uint16_t number, const char suit) const
+{
+    return CardSet::makeCode(getRankOfNumber(number), _getSuitIndex(suit));
+}
+
+uint8_t
+Rules::getCardCode(const char face, const char suit) const
+{
+    return CardSet::makeCode(getRankOfFace(face), _getSuitIndex(suit));
+}
+
+const Card*
+Rules::getCard(const uint8_t code) const
+{
+    if (code >= CardSet::sNumCards) {
+        throw std::out_of_range("invalid card code");
+    }
+    return _cards[code];
+}
+
+CardSet
+Rules::getCardSet(const std::vector<CardPtr>& cards) const
+{
+    CardSet set;
+    for (uint16_t i = 0; i < cards.size(); ++i) {
+        set.add(getCardCode(*cards[i]));
+    }
+    return set;
+}
+
+uint16_t
+Rules::getRankOfNumber(const uint16_t number)
+{
+    return getRankOfValue((number == 2) ? 15 : number);
+}
+
+uint16_t
+Rules::getRankOfFace(const char face)
+{
+    const FaceList& faces = Card::getFaceList();
+    FaceList::const_iterator it = faces.find(face);
+    if (it == faces.end()) {
+        throw std::invalid_argument("unknown face");
+    }
+    return getRankOfValue(it->second);
+}
+
+uint16_t
+Rules::getRankOfValue(const uint16_t value)
+{
+    // 3 is the lowest value, 2 (value 15) the highest
+    if (value < 3 || value > 15) {
+        throw std::invalid_argument("invalid card value");
+    }
+    return value - 3;
+}
+
+const Card*
+Rules::getInternedCard(const uint16_t rank, const char suit)
+{
+    // [rank][suit in Card::Clubs, Spades, Hearts, Diamonds order], built on
+    // first use (thread-safe) and never changed or freed
+    static const std::vector<Card> cards = _createCards();
+    if (rank >= CardSet::sNumRanks) {
+        throw std::out_of_range("invalid card rank");
+    }
+    return &cards[rank * CardSet::sNumSuits + _getInternedSuitIndex(suit)];
+}
+
+const Rules&
+Rules::standard(void)
+{
+    // initialized exactly once, even when first called from several threads
+    static const Rules rules = _createStandard();
+    return rules;
+}
+
+uint16_t
+Rules::_getInternedSuitIndex(const char suit)
+{
+    switch (suit) {
+      case Card::Clubs:    return 0;
+      case Card::Spades:   return 1;
+      case Card::Hearts:   return 2;
+      case Card::Diamonds: return 3;
+      default:
+        throw std::invalid_argument("unknown suit");
+    }
+}
+
+std::vector<Card>
+Rules::_createCards(void)
+{
+    const char suits[CardSet::sNumSuits] = { Card::Clubs, Card::Spades, Card::Hearts, Card::Diamonds };
+    const FaceList& faces = Card::getFaceList();
+    std::vector<Card> cards;
+    cards.reserve(CardSet::sNumCards);
+    for (uint16_t value = 3; value <= 15; ++value) {
+        for (uint16_t s = 0; s < CardSet::sNumSuits; ++s) {
+            if (value <= 10 || value == 15) {
+                // number cards, 2s are highest-value cards
+                uint16_t number = (value == 15) ? 2 : value;
+                cards.push_back(Card(number, suits[s], value));
+            }
+            else {
+                FaceList::const_iterator faceIt = faces.begin();
+                while (faceIt != faces.end() && faceIt->second != value) {
+                    ++faceIt;
+                }
+                if (faceIt == faces.end()) {
+                    throw std::logic_error("no face card of value " + std::to_string(value));
+                }
+                cards.push_back(Card(faceIt->first, suits[s], value));
+            }
+        }
+    }
+    return cards;
+}
+
+Rules
+Rules::_createStandard(void)
+{
+    Rules rules;
+    for (SuitList::const_iterator it = rules._suitList.begin();
+         it != rules._suitList.end(); ++it) {
+        Card::setSuitRank(it->first, it->second);
+    }
+    // force lazy initialization of the face table while still single-threaded
+    Card::getFaceList();
+    return rules;
+}
+
+} /* namespace pusoydos */
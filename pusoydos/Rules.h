@@ -0,0 +1,66 @@
+#ifndef _PUSOYDOS_RULES_H_
+#define _PUSOYDOS_RULES_H_
+
+#include <vector>
+
+// game
+#include "Card.h"
+
+// pusoydos
+#include "CardSet.h"
+
+using namespace game;
+
+namespace pusoydos {
+
+// per-game rules context (suit ranking); lets independent games run on
+// separate threads without sharing the global Card suit ranking
+class Rules
+{
+  public:
+    // standard pusoy dos ranking: clubs < spades < hearts < diamonds
+    Rules(void);
+
+    void setSuitRank(const char suit, const uint16_t rank);
+    uint16_t getSuitRank(const char suit) const;
+    const SuitList& getSuitList(void) const;
+
+    // mapping between cards and CardSet codes under this suit ranking
+    uint8_t getCardCode(const Card& card) const;
+    // interned card (see getInternedCard)
+    const Card* getCard(const uint8_t code) const;
+    CardSet getCardSet(const std::vector<CardPtr>& cards) const;
+
+    // code of a card given by number (2-10) or face and suit
+    uint8_t getCardCode(const uint16_t number, const char suit) const;
+    uint8_t getCardCode(const char face, const char suit) const;
+
+    // rank (0 = 3 ... 12 = 2) of a card number (2-10), face or value
+    static uint16_t getRankOfNumber(const uint16_t number);
+    static uint16_t getRankOfFace(const char face);
+    static uint16_t getRankOfValue(const uint16_t value);
+
+    // process-wide immutable card of a rank (0 = 3 ... 12 = 2) and suit,
+    // built once and shared by every game whatever its suit ranking
+    static const Card* getInternedCard(const uint16_t rank, const char suit);
+
+    // shared immutable instance with the standard ranking; first call also
+    // publishes the ranking to Card (read by library code such as Hand)
+    static const Rules& standard(void);
+
+  private:
+    SuitList _suitList;
+    // interned card per code under this suit ranking
+    const Card* _cards[CardSet::sNumCards];
+
+    uint16_t _getSuitIndex(const char suit) const;
+    void _buildCardTable(void);
+
+    static Rules _createStandard(void);
+    static uint16_t _getInternedSuitIndex(const char suit);
+    static std::vector<Card> _createCards(void);
+};
+
+} /* namespace pusoydos */
+
+#endif
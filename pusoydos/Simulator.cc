@@ -0,0 +1,361 @@
+#include <time.h>
+#include <math.h>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <memory>
+
+#include "Game.h"
+#include "GameRecord.h"
+#include "Simulator.h"
+
+namespace pusoydos {
+
+static double
+monotonicSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+Simulator::Simulator(const std::vector<std::string>& lineup,
+                     const uint64_t numGames,
+                     const uint32_t seed,
+                     const uint16_t numThreads,
+                     const uint64_t firstGame)
+    : _lineup(lineup),
+      _numGames(numGames),
+      _seed(seed),
+      _firstGame(firstGame),
+      _numThreads(numThreads),
+      _transcriptPolicy(AsyncLogWriter::kBlock),
+      _transcriptDropped(0),
+      _duplicate(false),
+      _wins(lineup.size(), 0),
+      _starterWins(0),
+      _elapsed(0.0)
+{
+    if (_numThreads == 0) {
+        _numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (std::find(_lineup.begin(), _lineup.end(), "human") != _lineup.end()) {
+        throw std::invalid_argument("simulation lineup cannot contain human players");
+    }
+    for (uint16_t i = 0; i < _lineup.size(); ++i) {
+        if (std::find(_types.begin(), _types.end(), _lineup[i]) == _types.end()) {
+            _types.push_back(_lineup[i]);
+        }
+    }
+    _arrangements.push_back(_lineup);
+}
+
+Simulator::TypeTally::TypeTally(void)
+    : wins(0),
+      score(0.0),
+      scoreSquares(0.0),
+      leads(0),
+      leadWins(0)
+{
+}
+
+void
+Simulator::TypeTally::add(const TypeTally& other)
+{
+    wins += other.wins;
+    score += other.score;
+    scoreSquares += other.scoreSquares;
+    leads += other.leads;
+    leadWins += other.leadWins;
+}
+
+void
+Simulator::_runWorker(const std::vector<std::vector<std::string> >* arrangements,
+                      const std::vector<std::string>* types,
+                      const uint64_t seed,
+                      const uint64_t firstGame,
+                      const uint64_t numGames,
+                      GameRecordWriter* writer,
+                      AsyncLogWriter* transcript,
+                      std::vector<uint64_t>* wins,
+                      std::vector<TypeTally>* tallies,
+                      uint64_t* starterWins,
+                      std::exception_ptr* error)
+{
+    try {
+        uint16_t numArrangements = arrangements->size();
+        uint16_t numPlayers = (*arrangements)[0].size();
+        AsyncLogWriter::Channel* channel = transcript ? transcript->openChannel() : NULL;
+        std::unique_ptr<TranscriptEventSink> sink;
+        // the games of a worker take turns, so their cpu seats can share
+        // one solver instead of one each per arrangement; it is cleared for
+        // every game like the players' own ones (see CpuPlayer::reset)
+        std::unique_ptr<EndgameSolver> solver;
+        if (numArrangements > 1) {
+            solver.reset(new EndgameSolver());
+        }
+
+        // every worker owns a game per arrangement (and with it the rules
+        // context), typeOf[a][seat] indexes types
+        std::vector<std::unique_ptr<Game> > games;
+        std::vector<std::vector<uint16_t> > typeOf(numArrangements);
+        for (uint16_t a = 0; a < numArrangements; ++a) {
+            games.push_back(std::unique_ptr<Game>(new Game((*arrangements)[a])));
+            games[a]->setRecordWriter(writer);
+            if (channel) {
+                if (!sink) {
+                    sink.reset(new TranscriptEventSink(games[a]->getRules(), channel));
+                }
+                games[a]->setEventSink(sink.get());
+            }
+            if (solver) {
+                games[a]->setEndgameSolver(solver.get());
+            }
+            for (uint16_t i = 0; i < numPlayers; ++i) {
+                typeOf[a].push_back(std::find(types->begin(), types->end(), (*arrangements)[a][i]) - types->begin());
+            }
+        }
+        std::vector<uint16_t> seats(types->size(), 0);
+        for (uint16_t i = 0; i < numPlayers; ++i) {
+            ++seats[typeOf[0][i]];
+        }
+
+        std::vector<uint16_t> dealWins(types->size());
+        for (uint64_t n = 0; n < numGames; ++n) {
+            std::fill(dealWins.begin(), dealWins.end(), 0);
+            for (uint16_t a = 0; a < numArrangements; ++a) {
+                // game n of the run always draws from the streams of game n,
+                // whatever the thread count and arrangement
+                games[a]->setSeed(seed, firstGame + n);
+                if (solver) {
+                    solver->clear();
+                }
+                uint16_t winner = games[a]->simulateSet();
+                uint16_t starter = games[a]->getStartingSeat();
+                ++(*wins)[winner];
+                ++dealWins[typeOf[a][winner]];
+                TypeTally& lead = (*tallies)[typeOf[a][starter]];
+                ++lead.leads;
+                if (winner == starter) {
+                    ++(*starterWins);
+                    ++lead.leadWins;
+                }
+            }
+            for (uint16_t i = 0; i < types->size(); ++i) {
+                double score = (double)dealWins[i] / numArrangements - (double)seats[i] / numPlayers;
+                (*tallies)[i].wins += dealWins[i];
+                (*tallies)[i].score += score;
+                (*tallies)[i].scoreSquares += score * score;
+            }
+        }
+        if (channel) {
+            channel->flush();
+        }
+    }
+    catch (...) {
+        *error = std::current_exception();
+    }
+}
+
+void
+Simulator::setRecordFile(const std::string& path)
+{
+    _recordFile = path;
+}
+
+void
+Simulator::setTranscriptFile(const std::string& path, const AsyncLogWriter::OverflowT policy)
+{
+    _transcriptFile = path;
+    _transcriptPolicy = policy;
+}
+
+uint64_t
+Simulator::getTranscriptDropped(void) const
+{
+    return _transcriptDropped;
+}
+
+void
+Simulator::setDuplicate(const bool duplicate)
+{
+    _duplicate = duplicate;
+    _arrangements.clear();
+    if (!_duplicate) {
+        _arrangements.push_back(_lineup);
+        return;
+    }
+    // distinct orders of the types over the seats, once each
+    std::vector<std::string> arrangement = _lineup;
+    std::sort(arrangement.begin(), arrangement.end());
+    do {
+        _arrangements.push_back(arrangement);
+    }
+    while (std::next_permutation(arrangement.begin(), arrangement.end()));
+}
+
+void
+Simulator::run(void)
+{
+    // one writer shared by all workers, records carry their game id
+    std::unique_ptr<GameRecordWriter> writer;
+    if (!_recordFile.empty()) {
+        writer.reset(new GameRecordWriter(_recordFile));
+    }
+    // workers only format and stage transcript lines, the file is written
+    // from the transcript's own thread
+    std::unique_ptr<AsyncLogWriter> transcript;
+    if (!_transcriptFile.empty()) {
+        transcript.reset(new AsyncLogWriter(_transcriptFile, _transcriptPolicy));
+    }
+
+    // workers only write to their own tally, merged after join
+    std::vector<std::vector<uint64_t> > workerWins(_numThreads,
+                                                   std::vector<uint64_t>(_lineup.size(), 0));
+    std::vector<std::vector<TypeTally> > workerTallies(_numThreads,
+                                                       std::vector<TypeTally>(_types.size()));
+    std::vector<uint64_t> workerStarterWins(_numThreads, 0);
+    std::vector<std::exception_ptr> errors(_numThreads);
+    std::vector<std::thread> workers;
+    double start = monotonicSeconds();
+    uint64_t firstGame = _firstGame;
+    for (uint16_t t = 0; t < _numThreads; ++t) {
+        uint64_t numGames = _numGames / _numThreads + (t < _numGames % _numThreads ? 1 : 0);
+        workers.push_back(std::thread(_runWorker, &_arrangements, &_types, _seed,
+                                      firstGame, numGames,
+                                      writer.get(), transcript.get(),
+                                      &workerWins[t], &workerTallies[t],
+                                      &workerStarterWins[t], &errors[t]));
+        firstGame += numGames;
+    }
+    for (uint16_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    if (writer) {
+        writer->flush();
+    }
+    if (transcript) {
+        // writes what is still staged
+        _transcriptDropped = transcript->getNumDropped();
+        transcript.reset();
+    }
+    _elapsed = monotonicSeconds() - start;
+    for (uint16_t t = 0; t < _numThreads; ++t) {
+        if (errors[t]) {
+            std::rethrow_exception(errors[t]);
+        }
+    }
+
+    std::fill(_wins.begin(), _wins.end(), 0);
+    _tallies.assign(_types.size(), TypeTally());
+    _starterWins = 0;
+    for (uint16_t t = 0; t < _numThreads; ++t) {
+        for (uint16_t i = 0; i < _wins.size(); ++i) {
+            _wins[i] += workerWins[t][i];
+        }
+        for (uint16_t i = 0; i < _types.size(); ++i) {
+            _tallies[i].add(workerTallies[t][i]);
+        }
+        _starterWins += workerStarterWins[t];
+    }
+}
+
+uint64_t
+Simulator::getNumGames(void) const
+{
+    return _numGames;
+}
+
+uint16_t
+Simulator::getNumThreads(void) const
+{
+    return _numThreads;
+}
+
+uint64_t
+Simulator::getWins(const uint16_t seat) const
+{
+    return _wins.at(seat);
+}
+
+uint64_t
+Simulator::getStarterWins(void) const
+{
+    return _starterWins;
+}
+
+double
+Simulator::getElapsedSeconds(void) const
+{
+    return _elapsed;
+}
+
+void
+Simulator::printSummary(std::ostream& os) const
+{
+    uint64_t numSets = _numGames * _arrangements.size();
+    double gamesPerSec = (_elapsed > 0.0) ? numSets / _elapsed : 0.0;
+    os << "games: " << _numGames
+       << "  seed: " << _seed
+       << "  first game: " << _firstGame
+       << "  threads: " << _numThreads
+       << "  time: " << std::fixed << std::setprecision(3) << _elapsed << "s"
+       << "  games/sec: " << std::setprecision(1) << gamesPerSec << "\n";
+    if (_transcriptDropped > 0) {
+        os << "transcript lines dropped: " << _transcriptDropped << "\n";
+    }
+    for (uint16_t i = 0; i < _wins.size(); ++i) {
+        double pct = (numSets > 0) ? 100.0 * _wins[i] / numSets : 0.0;
+        os << "seat " << i+1;
+        if (!_duplicate) {
+            // in duplicate mode the types take turns at every seat
+            os << " (" << std::setw(5) << std::left << _lineup[i] << std::right << ")";
+        }
+        os << "  wins: " << std::setw(10) << _wins[i]
+           << "  " << std::setw(6) << std::setprecision(2) << pct << "%\n";
+    }
+    double starterPct = (numSets > 0) ? 100.0 * _starterWins / numSets : 0.0;
+    os << "3C lead  wins: " << std::setw(10) << _starterWins
+       << "  " << std::setw(6) << starterPct << "%\n";
+    if (!_duplicate) {
+        return;
+    }
+
+    // the score of a type is its share of a deal's wins less its share of
+    // the seats, in points; the interval comes from its spread over deals
+    os << "duplicate: " << _arrangements.size() << " arrangements per deal, "
+       << numSets << " sets\n";
+    for (uint16_t i = 0; i < _types.size(); ++i) {
+        const TypeTally& tally = _tallies[i];
+        double n = _numGames;
+        double mean = (n > 0) ? tally.score / n : 0.0;
+        double variance = (n > 1) ? (tally.scoreSquares - n * mean * mean) / (n - 1) : 0.0;
+        double margin = (n > 0) ? 1.96 * sqrt(std::max(variance, 0.0) / n) : 0.0;
+        double leadPct = (tally.leads > 0) ? 100.0 * tally.leadWins / tally.leads : 0.0;
+        os << std::setw(12) << std::left << _types[i] << std::right
+           << "  wins: " << std::setw(10) << tally.wins
+           << "  score: " << std::showpos << std::setw(7) << 100.0 * mean << std::noshowpos
+           << " +- " << std::setw(5) << 100.0 * margin << " pts"
+           << "  3C leads: " << std::setw(10) << tally.leads
+           << "  won: " << std::setw(6) << leadPct << "%\n";
+    }
+}
+
+std::vector<std::string>
+Simulator::parseLineup(const std::string& lineup)
+{
+    std::vector<std::string> types;
+    std::istringstream iss(lineup);
+    std::string type;
+    while (std::getline(iss, type, ',')) {
+        if (!type.empty()) {
+            types.push_back(type);
+        }
+    }
+    return types;
+}
+
+} /* namespace pusoydos */
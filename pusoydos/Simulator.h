@@ -0,0 +1,119 @@
+#ifndef _PUSOYDOS_SIMULATOR_H_
+#define _PUSOYDOS_SIMULATOR_H_
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+#include <exception>
+
+// pusoydos
+#include "AsyncLogWriter.h"
+
+namespace pusoydos {
+
+class GameRecordWriter;
+
+// tournament runner: plays headless sets (one deal played until a player
+// runs out of cards), spread over worker threads that each own a Game,
+// and merges the per-seat win distribution once all workers are done
+class Simulator
+{
+  public:
+    // numThreads of 0 uses all hardware threads; plays games firstGame to
+    // firstGame + numGames - 1 of the experiment given by seed, so shards
+    // of one experiment can run anywhere without coordination
+    Simulator(const std::vector<std::string>& lineup,
+              const uint64_t numGames,
+              const uint32_t seed,
+              const uint16_t numThreads = 1,
+              const uint64_t firstGame = 0);
+
+    // appends a record of every game played by run() to path (see
+    // GameRecord); empty path for none
+    void setRecordFile(const std::string& path);
+
+    // appends a text transcript of every game (see TranscriptEventSink)
+    // to path from a background writer; empty path for none
+    void setTranscriptFile(const std::string& path,
+                           const AsyncLogWriter::OverflowT policy = AsyncLogWriter::kBlock);
+    // transcript lines dropped by the last run (kDrop policy)
+    uint64_t getTranscriptDropped(void) const;
+
+    // duplicate mode: every deal is played once per distinct arrangement
+    // of the lineup over the seats, so each player type holds every hand
+    // equally often and the luck of the deal cancels out. Types are then
+    // scored per deal against their fair share of the wins, see
+    // printSummary; numGames counts deals
+    void setDuplicate(const bool duplicate);
+
+    void run(void);
+
+    uint64_t getNumGames(void) const;
+    uint16_t getNumThreads(void) const;
+    uint64_t getWins(const uint16_t seat) const;
+    // sets won by the seat that held the 3 of clubs and led
+    uint64_t getStarterWins(void) const;
+    double getElapsedSeconds(void) const;
+
+    void printSummary(std::ostream& os) const;
+
+    // parses comma separated list of player types, e.g. "cpu,cpu,cpu,cpu"
+    static std::vector<std::string> parseLineup(const std::string& lineup);
+
+  private:
+    // results of one player type, summed over all its seats
+    class TypeTally
+    {
+      public:
+        TypeTally(void);
+
+        void add(const TypeTally& other);
+
+        uint64_t wins;
+        // sum and sum of squares over the deals of the duplicate score:
+        // the type's share of the wins of the deal less its share of seats
+        double   score;
+        double   scoreSquares;
+        // sets the type started with the 3 of clubs, and won
+        uint64_t leads;
+        uint64_t leadWins;
+    };
+
+    std::vector<std::string> _lineup;
+    uint64_t  _numGames;
+    uint32_t  _seed;
+    uint64_t  _firstGame;
+    std::string _recordFile;
+    uint16_t  _numThreads;
+    std::string _transcriptFile;
+    AsyncLogWriter::OverflowT _transcriptPolicy;
+    uint64_t  _transcriptDropped;
+
+    bool      _duplicate;
+    // lineups each deal is played with, one unless duplicate
+    std::vector<std::vector<std::string> > _arrangements;
+    // distinct player types in lineup order, and their tallies
+    std::vector<std::string> _types;
+    std::vector<TypeTally> _tallies;
+
+    std::vector<uint64_t> _wins;
+    uint64_t  _starterWins;
+    double    _elapsed;
+
+    static void _runWorker(const std::vector<std::vector<std::string> >* arrangements,
+                           const std::vector<std::string>* types,
+                           const uint64_t seed,
+                           const uint64_t firstGame,
+                           const uint64_t numGames,
+                           GameRecordWriter* writer,
+                           AsyncLogWriter* transcript,
+                           std::vector<uint64_t>* wins,
+                           std::vector<TypeTally>* tallies,
+                           uint64_t* starterWins,
+                           std::exception_ptr* error);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "Stats.h"
+
+namespace pusoydos {
+
+namespace {
+
+const char* sCounterNames[Stats::NUMCOUNTERS] = {
+    "deals", "sets", "rounds", "turns", "passes", "endgame_solves"
+};
+
+const char* sTimerNames[Stats::NUMTIMERS] = {
+    "deal", "round", "decision", "find_combo",
+    "try_four_kind", "try_full_house", "try_straight",
+    "try_three_kind", "try_pair", "try_single", "endgame"
+};
+
+// guards the registered blocks (Stats::sBlocks), the totals of threads that
+// have finished and the totals at the last reset
+std::mutex  sMutex;
+Stats::Snapshot* sRetired = NULL;
+Stats::Snapshot* sBaseline = NULL;
+std::string sDumpPath;
+
+} /* anonymous namespace */
+
+const uint16_t Stats::sComboBase;
+const uint16_t Stats::sCallsBase;
+const uint16_t Stats::sNanosBase;
+const uint16_t Stats::sNumValues;
+
+Stats::Block* Stats::sBlocks = NULL;
+
+Stats::Snapshot::Snapshot(void)
+{
+    memset(_values, 0, sizeof(_values));
+}
+
+void
+Stats::Snapshot::printToStream(std::ostream& os) const
+{
+    uint64_t numSets = getCount(kSets);
+    os << "engine stats";
+    if (!isEnabled()) {
+        os << " (compiled out, build with make STATS=1)";
+    }
+    os << "\n";
+    for (uint16_t c = 0; c < NUMCOUNTERS; ++c) {
+        os << std::setw(16) << std::left << sCounterNames[c] << std::right
+           << std::setw(14) << getCount((CounterT)c) << "\n";
+    }
+    for (uint16_t t = 0; t < Combo::NUMTYPES; ++t) {
+        os << std::setw(16) << std::left << Combo::getComboTypeString((Combo::ComboT)t) << std::right
+           << std::setw(14) << getComboCount((Combo::ComboT)t) << "\n";
+    }
+    os << std::setw(16) << std::left << "phase" << std::right
+       << std::setw(14) << "calls"
+       << std::setw(14) << "total ms"
+       << std::setw(12) << "ns/call"
+       << std::setw(12) << "us/set" << "\n";
+    for (uint16_t t = 0; t < NUMTIMERS; ++t) {
+        uint64_t calls = getCalls((TimerT)t);
+        uint64_t nanos = getNanos((TimerT)t);
+        os << std::setw(16) << std::left << sTimerNames[t] << std::right
+           << std::setw(14) << calls
+           << std::fixed << std::setprecision(1)
+           << std::setw(14) << nanos * 1e-6
+           << std::setw(12) << (calls ? (double)nanos / calls : 0.0)
+           << std::setw(12) << (numSets ? nanos * 1e-3 / numSets : 0.0) << "\n";
+    }
+}
+
+Stats::Block::Block(void)
+    : _next(NULL),
+      _prev(NULL)
+{
+    for (uint16_t i = 0; i < sNumValues; ++i) {
+        _values[i].store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(sMutex);
+    _next = sBlocks;
+    if (sBlocks) {
+        sBlocks->_prev = this;
+    }
+    sBlocks = this;
+}
+
+Stats::Block::~Block(void)
+{
+    // keep the counts of the finished thread
+    std::lock_guard<std::mutex> lock(sMutex);
+    if (sRetired == NULL) {
+        sRetired = new Snapshot();
+    }
+    for (uint16_t i = 0; i < sNumValues; ++i) {
+        sRetired->_values[i] += _values[i].load(std::memory_order_relaxed);
+    }
+    if (_prev) {
+        _prev->_next = _next;
+    }
+    else {
+        sBlocks = _next;
+    }
+    if (_next) {
+        _next->_prev = _prev;
+    }
+}
+
+Stats::Snapshot
+Stats::snapshot(void)
+{
+    Snapshot snap;
+    std::lock_guard<std::mutex> lock(sMutex);
+    for (Block* block = sBlocks; block; block = block->_next) {
+        for (uint16_t i = 0; i < sNumValues; ++i) {
+            snap._values[i] += block->_values[i].load(std::memory_order_relaxed);
+        }
+    }
+    for (uint16_t i = 0; i < sNumValues; ++i) {
+        if (sRetired) {
+            snap._values[i] += sRetired->_values[i];
+        }
+        if (sBaseline) {
+            snap._values[i] -= sBaseline->_values[i];
+        }
+    }
+    return snap;
+}
+
+void
+Stats::reset(void)
+{
+    // blocks are only written by their threads, so a reset moves the
+    // baseline instead of clearing them
+    Snapshot snap = snapshot();
+    std::lock_guard<std::mutex> lock(sMutex);
+    if (sBaseline == NULL) {
+        sBaseline = new Snapshot();
+    }
+    for (uint16_t i = 0; i < sNumValues; ++i) {
+        sBaseline->_values[i] += snap._values[i];
+    }
+}
+
+bool
+Stats::isEnabled(void)
+{
+#ifdef PUSOYDOS_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void
+dumpStats(void)
+{
+    if (sDumpPath.empty()) {
+        return;
+    }
+    Stats::Snapshot snap = Stats::snapshot();
+    if (sDumpPath == "-") {
+        snap.printToStream(std::cerr);
+        return;
+    }
+    std::ofstream ofs(sDumpPath.c_str());
+    if (!ofs) {
+        std::cerr << "cannot write engine stats to " << sDumpPath << "\n";
+        return;
+    }
+    snap.printToStream(ofs);
+}
+
+void
+Stats::dumpAtExit(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(sMutex);
+    if (sDumpPath.empty() && !path.empty()) {
+        atexit(dumpStats);
+    }
+    sDumpPath = path;
+}
+
+const char*
+Stats::getCounterName(const CounterT counter)
+{
+    return sCounterNames[counter];
+}
+
+const char*
+Stats::getTimerName(const TimerT timer)
+{
+    return sTimerNames[timer];
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,163 @@
+#ifndef _PUSOYDOS_STATS_H_
+#define _PUSOYDOS_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+// pusoydos
+#include "Combo.h"
+
+namespace pusoydos {
+
+// engine counters and per-phase timers. Every thread counts into its own
+// block (plain relaxed stores, no shared cache lines), and snapshot() sums
+// the blocks of running and finished threads on demand. The engine only
+// counts through the PUSOYDOS_STATS_* macros below, which compile to
+// nothing unless the build defines PUSOYDOS_STATS (see Makefile).
+class Stats
+{
+  public:
+    typedef enum {
+        kDeals          = 0,
+        kSets           = 1,
+        kRounds         = 2,
+        kTurns          = 3,
+        kPasses         = 4,
+        kEndgameSolves  = 5,
+        NUMCOUNTERS     = 6
+    } CounterT;
+
+    typedef enum {
+        kDealTime         = 0,
+        kRoundTime        = 1,  // whole rounds, decisions included
+        kDecisionTime     = 2,  // players choosing a combo
+        kFindComboTime    = 3,
+        kTryFourKindTime  = 4,
+        kTryFullHouseTime = 5,
+        kTryStraightTime  = 6,
+        kTryThreeKindTime = 7,
+        kTryPairTime      = 8,
+        kTrySingleTime    = 9,
+        kEndgameTime      = 10,
+        NUMTIMERS         = 11
+    } TimerT;
+
+  private:
+    // counters, combos played by type, timer calls, timer nanoseconds
+    static const uint16_t sComboBase = NUMCOUNTERS;
+    static const uint16_t sCallsBase = sComboBase + Combo::NUMTYPES;
+    static const uint16_t sNanosBase = sCallsBase + NUMTIMERS;
+    static const uint16_t sNumValues = sNanosBase + NUMTIMERS;
+
+  public:
+    class Snapshot
+    {
+      public:
+        Snapshot(void);
+
+        uint64_t getCount(const CounterT counter) const { return _values[counter]; }
+        uint64_t getComboCount(const Combo::ComboT type) const { return _values[sComboBase + type]; }
+        uint64_t getCalls(const TimerT timer) const { return _values[sCallsBase + timer]; }
+        uint64_t getNanos(const TimerT timer) const { return _values[sNanosBase + timer]; }
+
+        // totals, plus time per set so phases can be weighed per game
+        void printToStream(std::ostream& os) const;
+
+      private:
+        friend class Stats;
+
+        uint64_t _values[sNumValues];
+    };
+
+    static void count(const CounterT counter, const uint64_t n = 1) { _local().add(counter, n); }
+    static void countCombo(const Combo::ComboT type) { _local().add(sComboBase + type, 1); }
+    static void addTime(const TimerT timer, const uint64_t nanos)
+    {
+        Block& block = _local();
+        block.add(sCallsBase + timer, 1);
+        block.add(sNanosBase + timer, nanos);
+    }
+
+    // adds the lifetime of the scope to timer
+    class ScopedTimer
+    {
+      public:
+        explicit ScopedTimer(const TimerT timer)
+            : _timer(timer),
+              _start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedTimer(void)
+        {
+            std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - _start;
+            addTime(_timer, elapsed.count());
+        }
+
+      private:
+        TimerT _timer;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    // sum over all threads so far
+    static Snapshot snapshot(void);
+    static void reset(void);
+
+    // false if the instrumentation is compiled out
+    static bool isEnabled(void);
+
+    // prints a snapshot to path ("-" for stderr) when the process exits
+    static void dumpAtExit(const std::string& path);
+
+    static const char* getCounterName(const CounterT counter);
+    static const char* getTimerName(const TimerT timer);
+
+  private:
+    // one per thread, registered while the thread runs
+    class Block
+    {
+      public:
+        Block(void);
+        ~Block(void);
+
+        // only the owning thread writes, so no read-modify-write is needed
+        void add(const uint16_t index, const uint64_t n)
+        {
+            _values[index].store(_values[index].load(std::memory_order_relaxed) + n,
+                                 std::memory_order_relaxed);
+        }
+
+      private:
+        friend class Stats;
+
+        std::atomic<uint64_t> _values[sNumValues];
+        Block* _next;
+        Block* _prev;
+    };
+
+    // registered blocks, guarded by the registry mutex (see Stats.cc)
+    static Block* sBlocks;
+
+    static Block& _local(void)
+    {
+        static thread_local Block block;
+        return block;
+    }
+};
+
+} /* namespace pusoydos */
+
+#ifdef PUSOYDOS_STATS
+#define PUSOYDOS_STATS_COUNT(counter) ::pusoydos::Stats::count(counter)
+#define PUSOYDOS_STATS_COMBO(type) ::pusoydos::Stats::countCombo(type)
+#define PUSOYDOS_STATS_TIME(timer) ::pusoydos::Stats::ScopedTimer _statsTimer(timer)
+#else
+#define PUSOYDOS_STATS_COUNT(counter) do { } while (0)
+#define PUSOYDOS_STATS_COMBO(type) do { } while (0)
+#define PUSOYDOS_STATS_TIME(timer) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,362 @@
+#include <string.h>
+#include <sstream>
+#include <stdexcept>
+
+#include "MoveGenerator.h"
+#include "Table.h"
+
+namespace pusoydos {
+
+/****************************************************
+ ******************* CardNames **********************
+ ****************************************************/
+
+CardNames::CardNames(const Rules& rules)
+{
+    for (uint16_t code = 0; code < CardSet::sNumCards; ++code) {
+        std::ostringstream oss;
+        rules.getCard(code)->printToStream(oss);
+        _names[code] = oss.str();
+    }
+}
+
+const std::string&
+CardNames::get(const uint8_t code) const
+{
+    return _names[code];
+}
+
+void
+CardNames::append(const CardSet& cards, std::string& line) const
+{
+    for (CardSet::MaskT m = cards.getMask(); m; m &= m - 1) {
+        line += ' ';
+        line += _names[__builtin_ctzll(m)];
+    }
+}
+
+bool
+CardNames::parse(const char* text, const size_t size, CardSet& cards) const
+{
+    cards.clear();
+    size_t i = 0;
+    while (i < size) {
+        if (text[i] == ' ') {
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        while (end < size && text[end] != ' ') {
+            ++end;
+        }
+        uint16_t code = 0;
+        while (code < CardSet::sNumCards &&
+               _names[code].compare(0, std::string::npos, text + i, end - i) != 0) {
+            ++code;
+        }
+        if (code == CardSet::sNumCards || cards.has(code)) {
+            return false;
+        }
+        cards.add(code);
+        i = end;
+    }
+    return true;
+}
+
+/****************************************************
+ ********************* Table ************************
+ ****************************************************/
+
+const uint64_t Table::sDealsPerTable;
+
+Table::Table(const uint64_t id, const std::vector<std::string>& lineup,
+             const uint64_t seed, EndgameSolver* solver,
+             ThreadPool* pool, const WakeFn& wake)
+    : _id(id),
+      _game(lineup),
+      _remote(NULL),
+      _remoteSeat(0),
+      _names(_game.getRules()),
+      _setOver(true),
+      _moveReady(false),
+      _thinking(false),
+      _wake(wake),
+      _numSets(0),
+      _numMoves(0)
+{
+    for (uint16_t i = 0; i < lineup.size(); ++i) {
+        if (lineup[i] == "human") {
+            throw std::invalid_argument("a table cannot seat a human player");
+        }
+        if (lineup[i] != "remote") {
+            continue;
+        }
+        if (_remote) {
+            throw std::invalid_argument("a table seats exactly one remote player");
+        }
+        _remote = static_cast<RemotePlayer*>(_game.getPlayer(i));
+        _remoteSeat = i;
+    }
+    if (!_remote) {
+        throw std::invalid_argument("a table seats exactly one remote player");
+    }
+    _game.setSeed(seed, id * sDealsPerTable);
+    _game.setEndgameSolver(solver);
+    _game.setDecisionPool(pool);
+    _game.setEventSink(this);
+}
+
+Table::~Table(void)
+{
+    // the worker would resume into members destroyed before _game
+    if (isThinking()) {
+        _game.getPlayer(_game.getToMove())->cancelMove();
+    }
+}
+
+void
+Table::start(void)
+{
+    _advance();
+}
+
+void
+Table::resume(void)
+{
+    _advance();
+}
+
+bool
+Table::isThinking(void) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _thinking;
+}
+
+void
+Table::handleLine(const char* line, const size_t size)
+{
+    if (!_remote->isWaiting()) {
+        _addError("not your turn");
+        return;
+    }
+    if (!_readMove(line, size)) {
+        _output += "turn\n";
+        return;
+    }
+    ++_numMoves;
+    _advance();
+}
+
+std::string&
+Table::getOutput(void)
+{
+    return _output;
+}
+
+uint64_t
+Table::getId(void) const
+{
+    return _id;
+}
+
+uint64_t
+Table::getNumSets(void) const
+{
+    return _numSets;
+}
+
+uint64_t
+Table::getNumMoves(void) const
+{
+    return _numMoves;
+}
+
+void
+Table::onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers)
+{
+    _begin("hand", _remoteSeat);
+    _names.append(hands[_remoteSeat], _output);
+    _output += '\n';
+}
+
+void
+Table::onLead(const uint8_t seat, const Combo& combo)
+{
+    _begin("lead", seat);
+    _names.append(combo.getCardSet(), _output);
+    _output += '\n';
+}
+
+void
+Table::onFollow(const uint8_t seat, const Combo& combo)
+{
+    _begin("follow", seat);
+    _names.append(combo.getCardSet(), _output);
+    _output += '\n';
+}
+
+void
+Table::onPass(const uint8_t seat)
+{
+    _begin("pass", seat);
+    _output += '\n';
+}
+
+void
+Table::onRoundWon(const uint8_t seat)
+{
+    _begin("round", seat);
+    _output += '\n';
+}
+
+void
+Table::onSetWon(const uint8_t seat, const uint16_t points)
+{
+    _begin("won", seat);
+    _output += ' ';
+    _output += std::to_string(points);
+    _output += '\n';
+}
+
+void
+Table::_advance(void)
+{
+    while (true) {
+        if (_setOver) {
+            _game.beginSet();
+            _setOver = false;
+        }
+        Combo move;
+        if (!_takeMove(move) &&
+            !_game.requestMove(move, [this](const Combo& decided,
+                                            const std::exception_ptr& error) {
+                _onMove(decided, error);
+            })) {
+            // the client's seat resumes from handleLine, on this thread
+            if (_game.getToMove() == _remoteSeat) {
+                _output += "turn\n";
+                return;
+            }
+            if (!_wake) {
+                _game.getPlayer(_game.getToMove())->waitForMove();
+            }
+            // a cpu seat resumes from a pool worker (see _onMove): either
+            // it already has, or the table stops until woken. Deciding
+            // under _mutex whether to stop is what keeps a resume racing
+            // this check from going unnoticed
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_moveReady) {
+                    _thinking = true;
+                    return;
+                }
+            }
+            _takeMove(move);
+        }
+        if (_game.playMove(move) == Game::kSetOver) {
+            ++_numSets;
+            _setOver = true;
+        }
+    }
+}
+
+bool
+Table::_takeMove(Combo& move)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_moveReady) {
+        return false;
+    }
+    _moveReady = false;
+    if (_moveError) {
+        std::exception_ptr error;
+        error.swap(_moveError);
+        std::rethrow_exception(error);
+    }
+    move = _move;
+    return true;
+}
+
+void
+Table::_onMove(const Combo& move, const std::exception_ptr& error)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _move = move;
+    _moveError = error;
+    _moveReady = true;
+    if (_thinking) {
+        // woken under the lock, so the server sees a thinking table until
+        // the wake is queued
+        _thinking = false;
+        _wake();
+    }
+}
+
+bool
+Table::_readMove(const char* line, const size_t size)
+{
+    const GameState& state = _game.getState();
+    // the seat to move leads when it holds the lead (see Game::playTurn)
+    bool leading = (state.leadPlayer == _remoteSeat);
+    if (size == 4 && memcmp(line, "pass", 4) == 0) {
+        if (leading) {
+            _addError("cannot pass the lead");
+            return false;
+        }
+        _remote->setMove(Combo());
+        return true;
+    }
+    CardSet cards;
+    if (size < 5 || memcmp(line, "play ", 5) != 0) {
+        _addError("unknown command");
+        return false;
+    }
+    if (!_names.parse(line + 5, size - 5, cards) || cards.size() == 0) {
+        _addError("invalid cards");
+        return false;
+    }
+    if (!_remote->getCards().contains(cards)) {
+        _addError("cards not in hand");
+        return false;
+    }
+
+    // the table's thread drives only this table until the move is set
+    static thread_local Combo moves[MoveGenerator::sMaxMoves];
+    uint16_t numMoves = MoveGenerator::generate(_remote->getCards(),
+                                                leading ? Combo() : state.combo,
+                                                state.firstCombo,
+                                                moves, MoveGenerator::sMaxMoves);
+    // the same cards can form several five-card types, play the best
+    const Combo* move = NULL;
+    for (uint16_t i = 0; i < numMoves; ++i) {
+        if (moves[i].getCardSet().getMask() == cards.getMask() &&
+            (!move || move->getKey() < moves[i].getKey())) {
+            move = &moves[i];
+        }
+    }
+    if (!move) {
+        _addError("not a legal play");
+        return false;
+    }
+    _remote->setMove(*move);
+    return true;
+}
+
+void
+Table::_begin(const char* event, const uint8_t seat)
+{
+    _output += event;
+    _output += ' ';
+    _output += std::to_string(seat + 1);
+}
+
+void
+Table::_addError(const char* reason)
+{
+    _output += "error ";
+    _output += reason;
+    _output += '\n';
+}
+
+} /* namespace pusoydos */
@@ -0,0 +1,144 @@
+#ifndef _PUSOYDOS_TABLE_H_
+#define _PUSOYDOS_TABLE_H_
+
+#include <mutex>
+#include <exception>
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+#include "Game.h"
+#include "GameEventSink.h"
+#include "Rules.h"
+
+namespace pusoydos {
+
+// card names of the table protocol ("3C", "10H", "AS"), formatted once
+class CardNames
+{
+  public:
+    CardNames(const Rules& rules);
+
+    const std::string& get(const uint8_t code) const;
+
+    // appends " <name>" per card, ascending codes
+    void append(const CardSet& cards, std::string& line) const;
+
+    // parses space separated names; false on an unknown or repeated card
+    bool parse(const char* text, const size_t size, CardSet& cards) const;
+
+  private:
+    std::string _names[CardSet::sNumCards];
+};
+
+// one table of the table server (see TableServer): a Game with a single
+// "remote" seat played by a client, the other seats played in process.
+// A table does no I/O: the server hands it the client's lines and sends
+// whatever it appends to the output, and the table plays the in-process
+// seats until the client is to move again. Sets follow each other until
+// the client leaves. Given a decision pool and a wake callback, a table
+// never waits for its cpu seats either: it stops while one thinks on the
+// pool and the server calls resume once woken.
+//
+// line protocol, seats counted from 1:
+//   server  hand <seat> <cards>        the client's seat and hand of a new set
+//           lead|follow <seat> <cards>
+//           pass <seat>
+//           round <seat>               everyone else passed, seat leads next
+//           won <seat> <points>        set over
+//           turn                       the client is to move
+//           error <reason>             the last line was ignored, or the
+//                                      table broke and the server closes
+//   client  play <cards>
+//           pass
+class Table : public GameEventSink
+{
+  public:
+    // called from a pool worker once an in-process seat has decided
+    typedef std::function<void(void)> WakeFn;
+
+    // lineup holds exactly one "remote" seat; the table plays deals of seed
+    // from its own range, so tables never share a deal. The cpu seats
+    // solve endgames with solver (not owned, NULL for their own ones); they
+    // and the ismcts seats decide on pool (see Game::setDecisionPool),
+    // waking the server with wake; without wake the table waits for them
+    Table(const uint64_t id, const std::vector<std::string>& lineup,
+          const uint64_t seed, EndgameSolver* solver = NULL,
+          ThreadPool* pool = NULL, const WakeFn& wake = WakeFn());
+
+    // cancels the decision of a thinking seat
+    ~Table(void);
+
+    // deals the first set and plays up to the client's first turn
+    void start(void);
+
+    // plays on once woken, on the thread that drives the table; throws the
+    // error of a seat whose decision failed, the table is then broken
+    void resume(void);
+
+    // an in-process seat is deciding on a pool thread; the table must
+    // not be destroyed until the resume (cancelled by the destructor)
+    bool isThinking(void) const;
+
+    // handles one line of the client, without its newline
+    void handleLine(const char* line, const size_t size);
+
+    // lines for the client; the server erases what it has sent
+    std::string& getOutput(void);
+
+    uint64_t getId(void) const;
+    uint64_t getNumSets(void) const;
+    uint64_t getNumMoves(void) const;
+
+    virtual void onDeal(const uint64_t gameId, const CardSet* hands, const uint16_t numPlayers);
+    virtual void onLead(const uint8_t seat, const Combo& combo);
+    virtual void onFollow(const uint8_t seat, const Combo& combo);
+    virtual void onPass(const uint8_t seat);
+    virtual void onRoundWon(const uint8_t seat);
+    virtual void onSetWon(const uint8_t seat, const uint16_t points);
+
+    // deals per table in the sequence of the seed
+    static const uint64_t sDealsPerTable = 1ULL << 20;
+
+  private:
+    uint64_t      _id;
+    Game          _game;
+    RemotePlayer* _remote;
+    uint8_t       _remoteSeat;
+    CardNames     _names;
+    std::string   _output;
+    bool          _setOver;
+    // move of the seat to move, once decided, and whether the table stopped
+    // for it; guarded by _mutex as a pool worker may hand the move over
+    mutable std::mutex _mutex;
+    Combo         _move;
+    std::exception_ptr _moveError;
+    bool          _moveReady;
+    bool          _thinking;
+    WakeFn        _wake;
+    uint64_t      _numSets;
+    uint64_t      _numMoves;
+
+    // plays the in-process seats until the client is to move
+    void _advance(void);
+    // resume target of every seat, on whichever thread decided
+    void _onMove(const Combo& move, const std::exception_ptr& error);
+    // the decided move, if any, which is then no longer ready; throws the
+    // error of a failed decision
+    bool _takeMove(Combo& move);
+    // hands the client's move to the remote seat, false with an error line
+    // if the line is not a legal move
+    bool _readMove(const char* line, const size_t size);
+
+    // starts the line of an event of seat
+    void _begin(const char* event, const uint8_t seat);
+    void _addError(const char* reason);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,494 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "TableServer.h"
+
+namespace pusoydos {
+
+const size_t TableServer::sMaxLineSize;
+const int TableServer::sMaxEvents;
+const int TableServer::sPollMillis;
+
+static std::runtime_error
+systemError(const std::string& what)
+{
+    return std::runtime_error(what + ": " + strerror(errno));
+}
+
+TableServer::Connection::Connection(const int fd, const uint64_t id,
+                                    const std::vector<std::string>& lineup,
+                                    const uint64_t seed, Loop* loop)
+    : fd(fd),
+      table(id, lineup, seed, loop->solver.get(), loop->decisions.get(),
+            [loop, this] { loop->wake(this); }),
+      sent(0),
+      writing(false),
+      numSets(0),
+      numMoves(0)
+{
+}
+
+TableServer::Loop::Loop(void)
+    : epollFd(-1),
+      solver(new EndgameSolver()),
+      decisions(new ThreadPool(1)),
+      wakeFd(-1),
+      numConnections(0),
+      numSets(0),
+      numMoves(0)
+{
+}
+
+void
+TableServer::Loop::wake(Connection* connection)
+{
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    woken.push_back(connection);
+    uint64_t one = 1;
+    // the counter only saturates, and a loop that is already due to wake
+    // needs no second write
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        throw std::runtime_error(std::string("eventfd write: ") + strerror(errno));
+    }
+}
+
+TableServer::TableServer(const std::vector<std::string>& lineup, const uint64_t seed,
+                         const uint16_t numLoops)
+    : _lineup(lineup),
+      _seed(seed),
+      _numLoops(numLoops),
+      _listenFd(-1),
+      _stopping(false),
+      _nextId(0)
+{
+    if (_numLoops == 0) {
+        _numLoops = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // fail here rather than on the first connection
+    Table check(0, _lineup, _seed);
+    // a loop holds a mutex, so the loops are built in place
+    std::vector<Loop>(_numLoops).swap(_loops);
+}
+
+TableServer::~TableServer(void)
+{
+    if (_listenFd >= 0) {
+        close(_listenFd);
+    }
+    if (!_unixPath.empty()) {
+        unlink(_unixPath.c_str());
+    }
+}
+
+void
+TableServer::listenUnix(const std::string& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    strcpy(addr.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    unlink(path.c_str());
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        throw systemError("cannot bind " + path);
+    }
+    _unixPath = path;
+    _listen(fd);
+}
+
+void
+TableServer::listenTcp(const uint16_t port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        throw systemError("cannot bind port " + std::to_string(port));
+    }
+    _listen(fd);
+}
+
+void
+TableServer::_listen(const int fd)
+{
+    if (listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        throw systemError("listen");
+    }
+    if (_listenFd >= 0) {
+        close(_listenFd);
+    }
+    _listenFd = fd;
+}
+
+void
+TableServer::run(void)
+{
+    if (_listenFd < 0) {
+        throw std::logic_error("table server is not listening");
+    }
+    for (uint16_t i = 0; i < _numLoops; ++i) {
+        _loops[i].epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (_loops[i].epollFd < 0) {
+            throw systemError("epoll_create1");
+        }
+        // every loop accepts; EPOLLEXCLUSIVE wakes one of them per connection
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.ptr = NULL;
+        if (epoll_ctl(_loops[i].epollFd, EPOLL_CTL_ADD, _listenFd, &ev) < 0) {
+            throw systemError("epoll_ctl");
+        }
+        _loops[i].wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_loops[i].wakeFd < 0) {
+            throw systemError("eventfd");
+        }
+        // the loop itself marks its wake-ups
+        ev.events = EPOLLIN;
+        ev.data.ptr = &_loops[i];
+        if (epoll_ctl(_loops[i].epollFd, EPOLL_CTL_ADD, _loops[i].wakeFd, &ev) < 0) {
+            throw systemError("epoll_ctl");
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (uint16_t i = 1; i < _numLoops; ++i) {
+        threads.push_back(std::thread(&TableServer::_runLoop, this, &_loops[i]));
+    }
+    _runLoop(&_loops[0]);
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    for (uint16_t i = 0; i < _numLoops; ++i) {
+        close(_loops[i].epollFd);
+        _loops[i].epollFd = -1;
+        close(_loops[i].wakeFd);
+        _loops[i].wakeFd = -1;
+    }
+}
+
+void
+TableServer::stop(void)
+{
+    _stopping.store(true);
+}
+
+void
+TableServer::_runLoop(Loop* loop)
+{
+    struct epoll_event events[sMaxEvents];
+    while (!_stopping.load()) {
+        int n = epoll_wait(loop->epollFd, events, sMaxEvents, sPollMillis);
+        bool woken = false;
+        for (int i = 0; i < n; ++i) {
+            Connection* connection = (Connection*)events[i].data.ptr;
+            if (!connection) {
+                _accept(loop);
+                continue;
+            }
+            if (events[i].data.ptr == loop) {
+                // after the batch, which may still hold events of the
+                // tables that are closed on resuming
+                woken = true;
+                continue;
+            }
+            bool open = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                open = _read(loop, connection);
+            }
+            if (open && (events[i].events & EPOLLOUT)) {
+                open = _write(loop, connection);
+            }
+            if (!open) {
+                _close(loop, connection);
+            }
+        }
+        if (woken) {
+            _resume(loop);
+        }
+    }
+    while (!loop->connections.empty()) {
+        _close(loop, *loop->connections.begin());
+    }
+    // deleting a thinking table cancels its seat's decision, after which
+    // nothing wakes the loop any more
+    for (std::unordered_set<Connection*>::iterator it = loop->closed.begin();
+         it != loop->closed.end(); ++it) {
+        delete *it;
+    }
+    loop->closed.clear();
+    std::lock_guard<std::mutex> lock(loop->wakeMutex);
+    loop->woken.clear();
+}
+
+void
+TableServer::_accept(Loop* loop)
+{
+    while (true) {
+        int fd = accept4(_listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            // EAGAIN once another loop took the connection
+            return;
+        }
+        int on = 1;
+        // fails harmlessly on unix-domain sockets
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        Connection* connection = new Connection(fd, _nextId.fetch_add(1), _lineup, _seed, loop);
+        loop->connections.insert(connection);
+        ++loop->numConnections;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = connection;
+        if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            _close(loop, connection);
+            continue;
+        }
+        try {
+            connection->table.start();
+        }
+        catch (const std::exception& e) {
+            _fail(loop, connection, e);
+            _close(loop, connection);
+            continue;
+        }
+        _count(loop, connection);
+        if (!_write(loop, connection)) {
+            _close(loop, connection);
+        }
+    }
+}
+
+bool
+TableServer::_read(Loop* loop, Connection* connection)
+{
+    char buffer[16 * 1024];
+    ssize_t n = read(connection->fd, buffer, sizeof(buffer));
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        return false;
+    }
+    if (n < 0) {
+        return true;
+    }
+    connection->input.append(buffer, n);
+
+    Table& table = connection->table;
+    size_t start = 0;
+    size_t end;
+    try {
+        while ((end = connection->input.find('\n', start)) != std::string::npos) {
+            size_t size = end - start;
+            if (size > 0 && connection->input[end - 1] == '\r') {
+                --size;
+            }
+            table.handleLine(connection->input.data() + start, size);
+            start = end + 1;
+        }
+    }
+    catch (const std::exception& e) {
+        // a table that breaks takes only its own connection down
+        _fail(loop, connection, e);
+        return false;
+    }
+    connection->input.erase(0, start);
+    _count(loop, connection);
+    if (connection->input.size() > sMaxLineSize) {
+        return false;
+    }
+    return _write(loop, connection);
+}
+
+bool
+TableServer::_write(Loop* loop, Connection* connection)
+{
+    std::string& output = connection->table.getOutput();
+    while (connection->sent < output.size()) {
+        ssize_t n = send(connection->fd, output.data() + connection->sent,
+                         output.size() - connection->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                return false;
+            }
+            break;
+        }
+        connection->sent += n;
+    }
+    bool pending = (connection->sent < output.size());
+    if (!pending) {
+        // the table appends to the same storage from now on
+        output.clear();
+        connection->sent = 0;
+    }
+    if (pending != connection->writing) {
+        struct epoll_event ev;
+        ev.events = pending ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.ptr = connection;
+        if (epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, connection->fd, &ev) < 0) {
+            return false;
+        }
+        connection->writing = pending;
+    }
+    return true;
+}
+
+void
+TableServer::_fail(Loop* loop, Connection* connection, const std::exception& e)
+{
+    std::string& output = connection->table.getOutput();
+    output += "error ";
+    output += e.what();
+    output += '\n';
+    _write(loop, connection);
+}
+
+void
+TableServer::_close(Loop* loop, Connection* connection)
+{
+    // closing the descriptor also removes it from the epoll set
+    close(connection->fd);
+    connection->fd = -1;
+    loop->connections.erase(connection);
+    // a thinking table still has a resume coming, which wakes the loop
+    // with it (isThinking and the wake share the table's lock)
+    if (connection->table.isThinking()) {
+        loop->closed.insert(connection);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(loop->wakeMutex);
+        loop->woken.erase(std::remove(loop->woken.begin(), loop->woken.end(), connection),
+                          loop->woken.end());
+    }
+    delete connection;
+}
+
+void
+TableServer::_resume(Loop* loop)
+{
+    uint64_t count;
+    if (read(loop->wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        throw systemError("eventfd read");
+    }
+    // a table thinks at most once at a time, so it is woken at most once
+    std::vector<Connection*> woken;
+    {
+        std::lock_guard<std::mutex> lock(loop->wakeMutex);
+        woken.swap(loop->woken);
+    }
+    for (size_t i = 0; i < woken.size(); ++i) {
+        Connection* connection = woken[i];
+        if (connection->fd < 0) {
+            loop->closed.erase(connection);
+            delete connection;
+            continue;
+        }
+        bool open = true;
+        try {
+            connection->table.resume();
+        }
+        catch (const std::exception& e) {
+            _fail(loop, connection, e);
+            open = false;
+        }
+        if (open) {
+            _count(loop, connection);
+            open = _write(loop, connection);
+        }
+        if (!open) {
+            _close(loop, connection);
+        }
+    }
+}
+
+void
+TableServer::_count(Loop* loop, Connection* connection)
+{
+    const Table& table = connection->table;
+    loop->numSets += table.getNumSets() - connection->numSets;
+    loop->numMoves += table.getNumMoves() - connection->numMoves;
+    connection->numSets = table.getNumSets();
+    connection->numMoves = table.getNumMoves();
+}
+
+uint16_t
+TableServer::getNumLoops(void) const
+{
+    return _numLoops;
+}
+
+uint64_t
+TableServer::getNumConnections(void) const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < _loops.size(); ++i) {
+        total += _loops[i].numConnections;
+    }
+    return total;
+}
+
+uint64_t
+TableServer::getNumSets(void) const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < _loops.size(); ++i) {
+        total += _loops[i].numSets;
+    }
+    return total;
+}
+
+uint64_t
+TableServer::getNumMoves(void) const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < _loops.size(); ++i) {
+        total += _loops[i].numMoves;
+    }
+    return total;
+}
+
+void
+TableServer::printSummary(std::ostream& os) const
+{
+    os << "loops: " << _numLoops
+       << "  connections: " << getNumConnections()
+       << "  sets: " << getNumSets()
+       << "  client moves: " << getNumMoves() << "\n";
+    for (size_t i = 0; i < _loops.size(); ++i) {
+        os << "loop " << std::setw(3) << i
+           << "  connections: " << std::setw(8) << _loops[i].numConnections
+           << "  sets: " << std::setw(10) << _loops[i].numSets << "\n";
+    }
+}
+
+} /* namespace pusoydos */
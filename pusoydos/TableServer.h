@@ -0,0 +1,143 @@
+#ifndef _PUSOYDOS_TABLESERVER_H_
+#define _PUSOYDOS_TABLESERVER_H_
+
+#include <mutex>
+#include <exception>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+#include <unordered_set>
+
+// pusoydos
+#include "Table.h"
+
+namespace pusoydos {
+
+// hosts many tables in one process (see Table for the line protocol):
+// every accepted connection gets a table of its own, and a fixed set of
+// epoll event loops, one per core by default, drive all of them. A loop
+// keeps the connections it accepted until they close, so a table is only
+// ever driven by one thread, and a client waiting to move costs a table's
+// memory instead of a thread. Moves that take a search never run on a
+// loop: the endgame solves of a loop's cpu seats and the searches of its
+// ismcts seats queue on the loop's one decision thread, which alone uses
+// the loop's endgame solver and transposition table. The thread wakes the
+// loop through an eventfd once a seat has decided, and the loop resumes
+// the table. Clients connect over a unix-domain socket or a loopback TCP
+// port. Linux only.
+class TableServer
+{
+  public:
+    // numLoops of 0 runs one loop per hardware thread
+    TableServer(const std::vector<std::string>& lineup, const uint64_t seed,
+                const uint16_t numLoops = 0);
+
+    ~TableServer(void);
+
+    // listens on path, replacing a stale socket file
+    void listenUnix(const std::string& path);
+    // listens on 127.0.0.1:port
+    void listenTcp(const uint16_t port);
+
+    // runs the loops on the calling thread and numLoops - 1 others until
+    // stop(), then closes every connection
+    void run(void);
+    // safe to call from a signal handler
+    void stop(void);
+
+    uint16_t getNumLoops(void) const;
+    uint64_t getNumConnections(void) const;
+    uint64_t getNumSets(void) const;
+    uint64_t getNumMoves(void) const;
+
+    void printSummary(std::ostream& os) const;
+
+    // longest line accepted from a client
+    static const size_t sMaxLineSize = 1024;
+
+  private:
+    class Loop;
+
+    class Connection
+    {
+      public:
+        Connection(const int fd, const uint64_t id,
+                   const std::vector<std::string>& lineup, const uint64_t seed,
+                   Loop* loop);
+
+        // -1 once closed while its table was thinking (see _close)
+        int         fd;
+        Table       table;
+        std::string input;
+        // bytes of the table's output already sent
+        size_t      sent;
+        // EPOLLOUT is armed
+        bool        writing;
+        // sets and client moves already added to the loop's counts
+        uint64_t    numSets;
+        uint64_t    numMoves;
+    };
+
+    class Loop
+    {
+      public:
+        Loop(void);
+
+        // called by a decision thread once a table of the loop can go on
+        void wake(Connection* connection);
+
+        int epollFd;
+        std::unordered_set<Connection*> connections;
+        // closed while thinking, deleted once woken
+        std::unordered_set<Connection*> closed;
+        // used only from the decision thread, so one solve at a time
+        std::unique_ptr<EndgameSolver> solver;
+        // runs the solves and searches of all the loop's tables
+        std::unique_ptr<ThreadPool> decisions;
+        // eventfd in the epoll set, written by wake
+        int wakeFd;
+        std::mutex wakeMutex;
+        // tables to resume, guarded by wakeMutex
+        std::vector<Connection*> woken;
+        uint64_t numConnections;
+        uint64_t numSets;
+        uint64_t numMoves;
+    };
+
+    std::vector<std::string> _lineup;
+    uint64_t  _seed;
+    uint16_t  _numLoops;
+    int       _listenFd;
+    std::string _unixPath;
+    std::atomic<bool> _stopping;
+    // ids of accepted connections, and of their tables
+    std::atomic<uint64_t> _nextId;
+    std::vector<Loop> _loops;
+
+    void _listen(const int fd);
+    void _runLoop(Loop* loop);
+    void _accept(Loop* loop);
+    // false once the connection is to be closed
+    bool _read(Loop* loop, Connection* connection);
+    bool _write(Loop* loop, Connection* connection);
+    void _close(Loop* loop, Connection* connection);
+    // tells the client why its table broke, as far as the socket takes it
+    // without blocking; the connection is to be closed after
+    void _fail(Loop* loop, Connection* connection, const std::exception& e);
+    // resumes the tables woken since the last time
+    void _resume(Loop* loop);
+    // adds what the table played since the last call to the loop's counts
+    void _count(Loop* loop, Connection* connection);
+
+    static const int sMaxEvents = 256;
+    // how long a loop sleeps before it looks at the stop flag again
+    static const int sPollMillis = 100;
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace pusoydos {
+
+const size_t ThreadPool::sMinTasks;
+
+ThreadPool::ThreadPool(const uint16_t numThreads)
+    : _firstTask(0),
+      _numTasks(0),
+      _numPending(0),
+      _stopping(false)
+{
+    uint16_t count = numThreads;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (uint16_t t = 0; t < count; ++t) {
+        _threads.push_back(std::thread(&ThreadPool::_runWorker, this));
+    }
+}
+
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _taskReady.notify_all();
+    for (uint16_t t = 0; t < _threads.size(); ++t) {
+        _threads[t].join();
+    }
+}
+
+void
+ThreadPool::submit(const std::function<void(void)>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_numTasks == _tasks.size()) {
+            std::vector<std::function<void(void)> > tasks(std::max<size_t>(sMinTasks, 2 * _tasks.size()));
+            for (size_t i = 0; i < _numTasks; ++i) {
+                tasks[i].swap(_tasks[(_firstTask + i) % _tasks.size()]);
+            }
+            _tasks.swap(tasks);
+            _firstTask = 0;
+        }
+        _tasks[(_firstTask + _numTasks) % _tasks.size()] = task;
+        ++_numTasks;
+        ++_numPending;
+    }
+    _taskReady.notify_one();
+}
+
+void
+ThreadPool::wait(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _tasksDone.wait(lock, [this] { return _numPending == 0; });
+    if (_error) {
+        std::exception_ptr error = _error;
+        _error = std::exception_ptr();
+        std::rethrow_exception(error);
+    }
+}
+
+uint16_t
+ThreadPool::getNumThreads(void) const
+{
+    return _threads.size();
+}
+
+void
+ThreadPool::_runWorker(void)
+{
+    while (true) {
+        std::function<void(void)> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _taskReady.wait(lock, [this] { return _stopping || _numTasks > 0; });
+            if (_numTasks == 0) {
+                // stopping and drained
+                return;
+            }
+            // swapped out, a copy could allocate
+            task.swap(_tasks[_firstTask]);
+            _firstTask = (_firstTask + 1) % _tasks.size();
+            --_numTasks;
+        }
+        std::exception_ptr error;
+        try {
+            task();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (error && !_error) {
+                _error = error;
+            }
+            done = (--_numPending == 0);
+        }
+        if (done) {
+            _tasksDone.notify_all();
+        }
+    }
+}
+
+} /* namespace pusoydos */
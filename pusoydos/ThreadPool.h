@@ -0,0 +1,54 @@
+#ifndef _PUSOYDOS_THREADPOOL_H_
+#define _PUSOYDOS_THREADPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+#include <stdint.h>
+
+namespace pusoydos {
+
+// fixed set of worker threads running submitted tasks; wait() blocks until
+// every submitted task has finished and rethrows the first task exception
+class ThreadPool
+{
+  public:
+    // numThreads of 0 uses all hardware threads
+    ThreadPool(const uint16_t numThreads);
+
+    ~ThreadPool(void);
+
+    void submit(const std::function<void(void)>& task);
+    void wait(void);
+
+    uint16_t getNumThreads(void) const;
+
+  private:
+    std::vector<std::thread> _threads;
+    // queued tasks, a ring that only grows, so a pool that has seen its
+    // longest queue takes nothing more from the heap to queue a task
+    std::vector<std::function<void(void)> > _tasks;
+    size_t _firstTask;
+    size_t _numTasks;
+    std::mutex _mutex;
+    std::condition_variable _taskReady;
+    std::condition_variable _tasksDone;
+    // tasks submitted but not yet finished
+    uint32_t _numPending;
+    bool _stopping;
+    std::exception_ptr _error;
+
+    void _runWorker(void);
+
+    static const size_t sMinTasks = 16;
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,169 @@
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+
+#include "TranspositionTable.h"
+
+namespace pusoydos {
+
+namespace {
+
+// data word: move cards in bits 0-51, move type in 52-55, value in 56-57,
+// work in 58-63; all zero for an empty slot
+const uint16_t sTypeShift = 52;
+const uint16_t sValueShift = 56;
+const uint16_t sWorkShift = 58;
+
+const uint64_t sHugePageSize = 2 * 1024 * 1024;
+
+} /* anonymous namespace */
+
+const uint16_t TranspositionTable::sBucketSize;
+
+TranspositionTable::Entry::Entry(void)
+    : value(0),
+      work(0),
+      moveType(Combo::kUndef),
+      moveCards()
+{
+}
+
+bool
+TranspositionTable::Entry::isMove(const Combo& move) const
+{
+    return (move.getType() == moveType && move.getCardSet() == moveCards);
+}
+
+TranspositionTable::TranspositionTable(const uint16_t sizeBits, const bool hugePages)
+    : _buckets(NULL),
+      _bucketMask(0),
+      _numBytes(0),
+      _hugePages(false)
+{
+    if (sizeBits < 2 || sizeBits > 40) {
+        throw std::invalid_argument("transposition table size out of range");
+    }
+    uint64_t numBuckets = (1ULL << sizeBits) / sBucketSize;
+    _bucketMask = numBuckets - 1;
+    _numBytes = numBuckets * sizeof(Bucket);
+
+    void* mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (hugePages && _numBytes % sHugePageSize == 0) {
+        // only succeeds if huge pages have been reserved
+        mem = mmap(NULL, _numBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        _hugePages = (mem != MAP_FAILED);
+    }
+#endif
+    if (mem == MAP_FAILED) {
+        mem = mmap(NULL, _numBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugePages) {
+            // transparent huge pages, if enabled
+            _hugePages = (madvise(mem, _numBytes, MADV_HUGEPAGE) == 0);
+        }
+#endif
+    }
+    // mmap returns page-aligned memory, so buckets stay cache-line aligned
+    _buckets = new (mem) Bucket[numBuckets];
+    clear();
+}
+
+TranspositionTable::~TranspositionTable(void)
+{
+    munmap(_buckets, _numBytes);
+}
+
+bool
+TranspositionTable::probe(const uint64_t key, Entry& entry) const
+{
+    const Bucket& bucket = _buckets[key & _bucketMask];
+    for (uint16_t i = 0; i < sBucketSize; ++i) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        if (data != 0 && (check ^ data) == key) {
+            _unpack(data, entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+TranspositionTable::store(const uint64_t key, const Entry& entry)
+{
+    Bucket& bucket = _buckets[key & _bucketMask];
+    Slot* victim = NULL;
+    uint8_t victimWork = 0xFF;
+    for (uint16_t i = 0; i < sBucketSize; ++i) {
+        Slot& slot = bucket.slots[i];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if (data == 0 || (check ^ data) == key) {
+            victim = &slot;
+            break;
+        }
+        uint8_t work = data >> sWorkShift;
+        if (work < victimWork) {
+            victim = &slot;
+            victimWork = work;
+        }
+    }
+    uint64_t data = _pack(entry);
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void
+TranspositionTable::clear(void)
+{
+    for (uint64_t b = 0; b <= _bucketMask; ++b) {
+        for (uint16_t i = 0; i < sBucketSize; ++i) {
+            _buckets[b].slots[i].data.store(0, std::memory_order_relaxed);
+            _buckets[b].slots[i].check.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t
+TranspositionTable::getNumEntries(void) const
+{
+    return (_bucketMask + 1) * sBucketSize;
+}
+
+bool
+TranspositionTable::usesHugePages(void) const
+{
+    return _hugePages;
+}
+
+uint8_t
+TranspositionTable::getWork(const uint64_t nodes)
+{
+    return (nodes == 0) ? 0 : 63 - __builtin_clzll(nodes);
+}
+
+uint64_t
+TranspositionTable::_pack(const Entry& entry)
+{
+    return entry.moveCards.getMask() |
+           ((uint64_t)(entry.moveType & 0xF) << sTypeShift) |
+           ((uint64_t)(entry.value & 0x3) << sValueShift) |
+           ((uint64_t)(entry.work & 0x3F) << sWorkShift);
+}
+
+void
+TranspositionTable::_unpack(const uint64_t data, Entry& entry)
+{
+    entry.moveCards = CardSet(data & CardSet::sFullMask);
+    entry.moveType = (Combo::ComboT)((data >> sTypeShift) & 0xF);
+    entry.value = (data >> sValueShift) & 0x3;
+    entry.work = data >> sWorkShift;
+}
+
+} /* namespace pusoydos */
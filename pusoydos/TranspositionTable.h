@@ -0,0 +1,90 @@
+#ifndef _PUSOYDOS_TRANSPOSITIONTABLE_H_
+#define _PUSOYDOS_TRANSPOSITIONTABLE_H_
+
+#include <atomic>
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+
+namespace pusoydos {
+
+// fixed-size transposition table keyed by Zobrist keys that any number of
+// search threads can probe and store into without locks. Each entry is two
+// 64-bit words written with relaxed atomics: the packed data and the key
+// XOR the data, so a probe that sees a torn entry from a concurrent store
+// fails its key check and is treated as a miss. Entries sit in buckets of
+// four that share a cache line; a store replaces the entry of the same key,
+// else an empty one, else the one that took the least work to compute.
+class TranspositionTable
+{
+  public:
+    class Entry
+    {
+      public:
+        Entry(void);
+
+        // search-defined result, 0 means none (1-3 usable)
+        uint8_t       value;
+        // log2 of the nodes searched to compute it (0-63), kept by the
+        // replacement policy
+        uint8_t       work;
+        // best play found, kUndef with no cards if none or a pass
+        Combo::ComboT moveType;
+        CardSet       moveCards;
+
+        bool hasMove(void) const { return !moveCards.empty(); }
+        bool isMove(const Combo& move) const;
+    };
+
+    // sizeBits: log2 of the number of entries (16 bytes each); hugePages
+    // backs the table with huge pages where the system allows, falling
+    // back to normal pages
+    TranspositionTable(const uint16_t sizeBits, const bool hugePages = false);
+
+    ~TranspositionTable(void);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    bool probe(const uint64_t key, Entry& entry) const;
+    void store(const uint64_t key, const Entry& entry);
+
+    // not safe while other threads probe or store
+    void clear(void);
+
+    uint64_t getNumEntries(void) const;
+    bool usesHugePages(void) const;
+
+    // log2 of a node count, for Entry::work
+    static uint8_t getWork(const uint64_t nodes);
+
+    static const uint16_t sBucketSize = 4;
+
+  private:
+    class Slot
+    {
+      public:
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    class alignas(64) Bucket
+    {
+      public:
+        Slot slots[sBucketSize];
+    };
+
+    Bucket*  _buckets;
+    uint64_t _bucketMask;
+    uint64_t _numBytes;
+    bool     _hugePages;
+
+    static uint64_t _pack(const Entry& entry);
+    static void _unpack(const uint64_t data, Entry& entry);
+};
+
+} /* namespace pusoydos */
+
+#endif
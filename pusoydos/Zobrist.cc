@@ -0,0 +1,47 @@
+#include "Zobrist.h"
+
+namespace pusoydos {
+
+namespace {
+
+// splitmix64, which fills a table with well-mixed distinct keys
+constexpr uint64_t
+nextKey(uint64_t& state)
+{
+    uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+} /* anonymous namespace */
+
+constexpr Zobrist::Keys
+Zobrist::_makeKeys(void)
+{
+    Keys keys{};
+    uint64_t state = 0x5059534F59444F53ULL;
+    for (uint16_t seat = 0; seat < GameState::sMaxPlayers; ++seat) {
+        for (uint16_t code = 0; code < CardSet::sNumCards; ++code) {
+            keys.cards[seat][code] = nextKey(state);
+        }
+    }
+    for (uint16_t code = 0; code < CardSet::sNumCards; ++code) {
+        keys.comboCards[code] = nextKey(state);
+    }
+    for (uint16_t type = 0; type <= Combo::kUndef; ++type) {
+        keys.comboTypes[type] = nextKey(state);
+    }
+    for (uint16_t seat = 0; seat < GameState::sMaxPlayers; ++seat) {
+        keys.leader[seat] = nextKey(state);
+        keys.toMove[seat] = nextKey(state);
+        keys.observer[seat] = nextKey(state);
+    }
+    keys.firstCombo = nextKey(state);
+    return keys;
+}
+
+// constant-initialized, so usable from other static initializers
+const Zobrist::Keys Zobrist::sKeys = Zobrist::_makeKeys();
+
+} /* namespace pusoydos */
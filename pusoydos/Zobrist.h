@@ -0,0 +1,77 @@
+#ifndef _PUSOYDOS_ZOBRIST_H_
+#define _PUSOYDOS_ZOBRIST_H_
+
+#include <stdint.h>
+
+// pusoydos
+#include "CardSet.h"
+#include "Combo.h"
+#include "GameState.h"
+
+namespace pusoydos {
+
+// Zobrist keys for search positions: a position key is the XOR of the keys
+// of every (seat, card) held, every card of the combo to beat with its
+// type, the leader, the player to move and the first-combo flag, so a play
+// updates it with a handful of XORs. Keys are generated at compile time.
+class Zobrist
+{
+  public:
+    static uint64_t getCardKey(const uint8_t seat, const uint8_t code)
+    {
+        return sKeys.cards[seat][code];
+    }
+
+    // XOR of the card keys of every card in cards held by seat
+    static uint64_t getHandKey(const uint8_t seat, const CardSet& cards)
+    {
+        uint64_t key = 0;
+        for (CardSet::MaskT m = cards.getMask(); m; m &= m - 1) {
+            key ^= sKeys.cards[seat][__builtin_ctzll(m)];
+        }
+        return key;
+    }
+
+    // 0 for an empty combo
+    static uint64_t getComboKey(const Combo& combo)
+    {
+        uint16_t size = combo.getSize();
+        if (size == 0) {
+            return 0;
+        }
+        uint64_t key = sKeys.comboTypes[combo.getType()];
+        for (uint16_t i = 0; i < size; ++i) {
+            key ^= sKeys.comboCards[combo.getCard(i)];
+        }
+        return key;
+    }
+
+    static uint64_t getLeaderKey(const uint8_t seat) { return sKeys.leader[seat]; }
+    static uint64_t getToMoveKey(const uint8_t seat) { return sKeys.toMove[seat]; }
+    static uint64_t getFirstComboKey(void) { return sKeys.firstCombo; }
+
+    // distinguishes the same position searched on behalf of different
+    // seats, for searches whose values are relative to one seat
+    static uint64_t getObserverKey(const uint8_t seat) { return sKeys.observer[seat]; }
+
+  private:
+    class Keys
+    {
+      public:
+        uint64_t cards[GameState::sMaxPlayers][CardSet::sNumCards];
+        uint64_t comboCards[CardSet::sNumCards];
+        uint64_t comboTypes[Combo::kUndef + 1];
+        uint64_t leader[GameState::sMaxPlayers];
+        uint64_t toMove[GameState::sMaxPlayers];
+        uint64_t observer[GameState::sMaxPlayers];
+        uint64_t firstCombo;
+    };
+
+    static const Keys sKeys;
+
+    static constexpr Keys _makeKeys(void);
+};
+
+} /* namespace pusoydos */
+
+#endif
@@ -0,0 +1,266 @@
+#include <new>
+#include <iostream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Benchmark.h"
+#include "CardSet.h"
+#include "Combo.h"
+#include "Game.h"
+#include "MoveGenerator.h"
+#include "Player.h"
+#include "Random.h"
+
+using namespace pusoydos;
+
+// count every heap allocation of the process for allocs/op
+void*
+operator new(size_t size)
+{
+    Benchmark::sAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void
+operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace {
+
+// inputs are drawn once from a fixed stream so every build times the same work
+const uint64_t sBenchSeed = 0x5eed;
+const uint16_t sNumInputs = 1024;
+const uint16_t sHandSize = 13;
+
+// 13-card hands of random deals
+void
+makeHands(CardSet* hands)
+{
+    for (uint16_t i = 0; i < sNumInputs; i += 4) {
+        Game::dealHands(sBenchSeed, i, 4, hands + i);
+    }
+}
+
+// every combo that can be led from the hands, in random order
+std::vector<Combo>
+makeCombos(const CardSet* hands)
+{
+    std::vector<Combo> combos;
+    Combo moves[MoveGenerator::sMaxMoves];
+    Combo none;
+    for (uint16_t i = 0; i < 16; ++i) {
+        uint16_t n = MoveGenerator::generate(hands[i], none, false, moves, MoveGenerator::sMaxMoves);
+        combos.insert(combos.end(), moves, moves + n);
+    }
+    RandomStream rng(sBenchSeed, 0, 1);
+    for (size_t i = combos.size() - 1; i > 0; --i) {
+        std::swap(combos[i], combos[rng.below(i + 1)]);
+    }
+    return combos;
+}
+
+} /* anonymous namespace */
+
+namespace pusoydos {
+
+// drives the private hand analysis of CpuPlayer
+class CpuPlayerBench
+{
+  public:
+    CpuPlayerBench(const Rules* rules)
+    {
+        _player.setRules(rules);
+        _player.setSeat(0);
+    }
+
+    // every hand starts a new game, as on a deal
+    void setHand(const CardSet& hand)
+    {
+        _player.reset();
+        _player.setHand(hand);
+    }
+
+    // plays cards out of the hand, updating the analysis
+    void removeCards(const CardSet& cards) { _player._removeCards(cards); }
+
+    const Combo& findCombo(const Combo& curCombo, const bool leader)
+    {
+        _player._findCombo(curCombo, leader);
+        return _player._combo;
+    }
+
+    const CardSet& getHand(void) const { return _player.getCards(); }
+
+  private:
+    CpuPlayer _player;
+};
+
+} /* namespace pusoydos */
+
+static void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [-b filter] [-m min seconds per repetition] [-r repetitions]\n";
+    std::cerr << "prints results as JSON on stdout; ops_per_sec of game_headless is games/sec\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string filter;
+    double minSeconds = 0.2;
+    uint16_t numRepetitions = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i+1 < argc) {
+            minSeconds = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i+1 < argc) {
+            numRepetitions = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        Benchmark bench(minSeconds, numRepetitions);
+        bench.setFilter(filter);
+
+        static CardSet hands[sNumInputs];
+        makeHands(hands);
+        const std::vector<Combo> combos = makeCombos(hands);
+        const Rules& rules = Rules::standard();
+
+        bench.run("combo_add_card", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                const Combo& src = combos[i % combos.size()];
+                Combo combo((Combo::ComboT)src.getType());
+                for (uint16_t k = 0; k < src.getSize(); ++k) {
+                    combo.addCard(src.getCard(k));
+                }
+                Benchmark::keep(combo);
+            }
+        });
+
+        bench.run("combo_less", [&](const uint64_t n) {
+            // only combos of one size are compared in play
+            uint64_t less = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                const Combo& a = combos[i % combos.size()];
+                const Combo& b = combos[(i * 7 + 1) % combos.size()];
+                if (a.getSize() == b.getSize()) {
+                    less += (a < b);
+                }
+            }
+            Benchmark::keep(less);
+        });
+
+        bench.run("combo_sort", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Combo combo = combos[i % combos.size()];
+                combo.sort();
+                Benchmark::keep(combo);
+            }
+        });
+
+        bench.run("hand_insert_remove", [&](const uint64_t n) {
+            // deal a hand card by card, then play it out card by card
+            for (uint64_t i = 0; i < n; ++i) {
+                const CardSet& dealt = hands[i % sNumInputs];
+                CardSet hand;
+                for (uint16_t k = 0; k < sHandSize; ++k) {
+                    hand.add(dealt.nth(k));
+                }
+                for (uint16_t k = 0; k < sHandSize; ++k) {
+                    hand.remove(hand.lowest());
+                }
+                Benchmark::keep(hand);
+            }
+        });
+
+        CpuPlayerBench cpu(&rules);
+        bench.run("cpu_set_hand", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                cpu.setHand(hands[i % sNumInputs]);
+            }
+        });
+
+        bench.run("cpu_remove_cards", [&](const uint64_t n) {
+            // plays a hand out one card at a time
+            for (uint64_t i = 0; i < n; ++i) {
+                if (cpu.getHand().empty()) {
+                    cpu.setHand(hands[i % sNumInputs]);
+                }
+                cpu.removeCards(CardSet(CardSet::getBit(cpu.getHand().lowest())));
+            }
+        });
+
+        bench.run("cpu_find_combo", [&](const uint64_t n) {
+            // leads a combo from a fresh hand (the hand is played from)
+            Combo none;
+            for (uint64_t i = 0; i < n; ++i) {
+                cpu.setHand(hands[i % sNumInputs]);
+                Benchmark::keep(cpu.findCombo(none, true));
+            }
+        });
+
+        // the engine alone, the endgame solver is timed by game_endgame
+        std::vector<std::string> lineup(4, "cpu:0");
+        Game dealGame(lineup);
+        bench.run("game_deal", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                dealGame.deal(sBenchSeed, i);
+            }
+        });
+
+        Game game(lineup);
+        game.setSeed(sBenchSeed);
+        bench.run("game_headless", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Benchmark::keep(game.simulateSet());
+            }
+        });
+
+        // every seat solves its last 20 cards
+        Game endgameGame(std::vector<std::string>(4, "cpu:20"));
+        endgameGame.setSeed(sBenchSeed);
+        bench.run("game_endgame", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Benchmark::keep(endgameGame.simulateSet());
+            }
+        });
+
+        // searches on the player's pool, merging in its arena, every move
+        lineup[0] = "ismcts:200";
+        Game mctsGame(lineup);
+        mctsGame.setSeed(sBenchSeed);
+        bench.run("game_ismcts", [&](const uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Benchmark::keep(mctsGame.simulateSet());
+            }
+        });
+
+        bench.printJson(std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Evaluator.h"
+
+using namespace pusoydos;
+
+static void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " -a candidate -b baseline [-N seats] [-k candidate seats (default half)] [-n max games] [-s seed] [-t threads (0 = all cores)]\n";
+    std::cerr << "       [-e elo0:elo1 (sequential test, stops once decided)] [-A alpha] [-B beta]\n";
+    std::cerr << "player types: cpu (heuristic only), cpu:<endgame cards (at most 20)>[:<endgame nodes per move> (default 1600000)], ismcts[:<playouts>|:<N>ms][:<search threads>]\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string candidate;
+    std::string baseline;
+    uint16_t numPlayers = 4;
+    uint16_t numCandidates = 0;
+    uint64_t maxGames = 100000;
+    uint32_t seed = 1;
+    uint16_t numThreads = 0;
+    bool sprt = false;
+    double elo0 = 0.0;
+    double elo1 = 0.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i+1 < argc) {
+            candidate = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            baseline = argv[++i];
+        }
+        else if (strcmp(argv[i], "-N") == 0 && i+1 < argc) {
+            numPlayers = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-k") == 0 && i+1 < argc) {
+            numCandidates = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            maxGames = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            numThreads = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i+1 < argc) {
+            char* end;
+            elo0 = strtod(argv[++i], &end);
+            if (*end != ':') {
+                usage(argv[0]);
+                return 1;
+            }
+            elo1 = strtod(end + 1, NULL);
+            sprt = true;
+        }
+        else if (strcmp(argv[i], "-A") == 0 && i+1 < argc) {
+            alpha = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "-B") == 0 && i+1 < argc) {
+            beta = strtod(argv[++i], NULL);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (candidate.empty() || baseline.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (numCandidates == 0) {
+        numCandidates = numPlayers / 2;
+    }
+
+    try {
+        Evaluator eval(candidate, baseline, numPlayers, numCandidates, maxGames, seed, numThreads);
+        if (sprt) {
+            eval.setSprt(elo0, elo1, alpha, beta);
+        }
+        eval.run();
+        eval.printSummary(std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "evaluation failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
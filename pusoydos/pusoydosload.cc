@@ -0,0 +1,355 @@
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "ComboClassifier.h"
+#include "MoveGenerator.h"
+#include "Table.h"
+
+using namespace pusoydos;
+
+namespace {
+
+double
+monotonicSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// where the server listens, a unix socket path or a loopback port
+class Address
+{
+  public:
+    std::string path;
+    uint16_t    port;
+};
+
+// one table played by the load generator: always plays its lowest legal
+// combo, and times each move from sending it to the next turn
+class Client
+{
+  public:
+    Client(const CardNames& names, const uint64_t numSets)
+        : fd(-1),
+          sets(0),
+          moves(0),
+          errors(0),
+          sentAt(0.0),
+          _names(names),
+          _numSets(numSets),
+          _firstCombo(false)
+    {
+    }
+
+    int         fd;
+    std::string input;
+    uint64_t    sets;
+    uint64_t    moves;
+    uint64_t    errors;
+    // when the last move was sent, 0 before the first one
+    double      sentAt;
+
+    // handles one line of the server; false once the client is done
+    bool handleLine(const std::string& line, std::vector<uint32_t>& latencies);
+
+  private:
+    const CardNames& _names;
+    uint64_t _numSets;
+    CardSet  _hand;
+    Combo    _toBeat;
+    bool     _firstCombo;
+
+    void _play(void);
+};
+
+bool
+Client::handleLine(const std::string& line, std::vector<uint32_t>& latencies)
+{
+    std::string::size_type space = line.find(' ');
+    std::string event = line.substr(0, space);
+    // cards follow the seat of hand, lead and follow
+    std::string::size_type cards = (space == std::string::npos) ? space : line.find(' ', space + 1);
+    if (event == "turn") {
+        double now = monotonicSeconds();
+        if (sentAt > 0.0) {
+            latencies.push_back((now - sentAt) * 1e6);
+        }
+        _play();
+        sentAt = monotonicSeconds();
+    }
+    else if (event == "hand") {
+        _names.parse(line.data() + cards, line.size() - cards, _hand);
+        _toBeat.resetAll();
+        _firstCombo = true;
+    }
+    else if (event == "lead" || event == "follow") {
+        CardSet played;
+        _names.parse(line.data() + cards, line.size() - cards, played);
+        Combo::ComboT type = (played.size() == 5) ? ComboClassifier::classify(played).type
+                                                  : (Combo::ComboT)(played.size() - 1);
+        _toBeat.resetAll();
+        _toBeat.setType(type);
+        _toBeat.setCards(played);
+        _firstCombo = false;
+    }
+    else if (event == "round") {
+        _toBeat.resetAll();
+    }
+    else if (event == "won") {
+        return (++sets < _numSets);
+    }
+    else if (event == "error") {
+        ++errors;
+        return false;
+    }
+    return true;
+}
+
+void
+Client::_play(void)
+{
+    static thread_local Combo legal[MoveGenerator::sMaxMoves];
+    uint16_t numLegal = MoveGenerator::generate(_hand, _toBeat, _firstCombo,
+                                                legal, MoveGenerator::sMaxMoves);
+    std::string line;
+    if (numLegal == 0) {
+        line = "pass\n";
+    }
+    else {
+        line = "play";
+        _names.append(legal[0].getCardSet(), line);
+        line += '\n';
+        _hand.remove(legal[0].getCardSet());
+    }
+    ++moves;
+    if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t)line.size()) {
+        throw std::runtime_error(std::string("send: ") + strerror(errno));
+    }
+}
+
+int
+connectTo(const Address& address)
+{
+    int fd;
+    if (!address.path.empty()) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    else {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(address.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+        int on = 1;
+        if (fd >= 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+    }
+    if (fd < 0) {
+        throw std::runtime_error(std::string("cannot connect: ") + strerror(errno));
+    }
+    return fd;
+}
+
+// result of one load thread
+class Result
+{
+  public:
+    Result(void) : sets(0), moves(0), errors(0), dropped(0) { }
+
+    uint64_t sets;
+    uint64_t moves;
+    uint64_t errors;
+    // connections the server closed early
+    uint64_t dropped;
+    std::vector<uint32_t> latencies;
+    std::string failure;
+};
+
+// plays numClients tables of numSets sets each over one epoll set
+void
+runThread(const Address* address, const uint64_t numClients, const uint64_t numSets,
+          Result* result)
+{
+    CardNames names(Rules::standard());
+    std::vector<Client*> clients;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    try {
+        for (uint64_t i = 0; i < numClients; ++i) {
+            Client* client = new Client(names, numSets);
+            clients.push_back(client);
+            client->fd = connectTo(*address);
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = client;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, client->fd, &ev);
+        }
+
+        uint64_t open = numClients;
+        struct epoll_event events[256];
+        char buffer[16 * 1024];
+        while (open > 0) {
+            int n = epoll_wait(epollFd, events, 256, -1);
+            for (int i = 0; i < n; ++i) {
+                Client* client = (Client*)events[i].data.ptr;
+                ssize_t size = read(client->fd, buffer, sizeof(buffer));
+                bool more = (size > 0);
+                if (!more) {
+                    ++result->dropped;
+                }
+                else {
+                    client->input.append(buffer, size);
+                }
+                std::string::size_type start = 0;
+                std::string::size_type end;
+                while (more && (end = client->input.find('\n', start)) != std::string::npos) {
+                    more = client->handleLine(client->input.substr(start, end - start),
+                                              result->latencies);
+                    start = end + 1;
+                }
+                client->input.erase(0, start);
+                if (!more) {
+                    close(client->fd);
+                    client->fd = -1;
+                    --open;
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        result->failure = e.what();
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+        result->sets += clients[i]->sets;
+        result->moves += clients[i]->moves;
+        result->errors += clients[i]->errors;
+        if (clients[i]->fd >= 0) {
+            close(clients[i]->fd);
+        }
+        delete clients[i];
+    }
+    close(epollFd);
+}
+
+uint32_t
+percentile(const std::vector<uint32_t>& sorted, const double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min<size_t>(sorted.size() - 1, p * sorted.size())];
+}
+
+void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " (-u socket path | -P port) [-c connections] [-g sets per connection] [-t threads]\n";
+    std::cerr << "plays one table per connection against pusoydosserver, reports moves/sec and move latency\n";
+}
+
+} /* anonymous namespace */
+
+int main(int argc, const char* argv[])
+{
+    Address address;
+    address.port = 0;
+    uint64_t numClients = 100;
+    uint64_t numSets = 10;
+    uint16_t numThreads = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-u") == 0 && i+1 < argc) {
+            address.path = argv[++i];
+        }
+        else if (strcmp(argv[i], "-P") == 0 && i+1 < argc) {
+            address.port = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+            numClients = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+            numSets = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            numThreads = std::max(1ul, strtoul(argv[++i], NULL, 10));
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (address.path.empty() == (address.port == 0) || numSets == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Result> results(numThreads);
+    std::vector<std::thread> threads;
+    double start = monotonicSeconds();
+    for (uint16_t t = 0; t < numThreads; ++t) {
+        // spread the connections evenly over the threads
+        uint64_t count = numClients / numThreads + (t < numClients % numThreads ? 1 : 0);
+        threads.push_back(std::thread(runThread, &address, count, numSets, &results[t]));
+    }
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    double elapsed = monotonicSeconds() - start;
+
+    Result total;
+    for (size_t t = 0; t < results.size(); ++t) {
+        if (!results[t].failure.empty()) {
+            std::cerr << "load thread " << t << " failed: " << results[t].failure << "\n";
+            return 1;
+        }
+        total.sets += results[t].sets;
+        total.moves += results[t].moves;
+        total.errors += results[t].errors;
+        total.dropped += results[t].dropped;
+        total.latencies.insert(total.latencies.end(),
+                               results[t].latencies.begin(), results[t].latencies.end());
+    }
+    std::sort(total.latencies.begin(), total.latencies.end());
+
+    std::cout << "connections: " << numClients
+              << "  sets: " << total.sets
+              << "  moves: " << total.moves
+              << "  errors: " << total.errors
+              << "  dropped: " << total.dropped
+              << "  time: " << std::fixed << std::setprecision(3) << elapsed << "s"
+              << "  moves/sec: " << std::setprecision(1) << (elapsed > 0.0 ? total.moves / elapsed : 0.0) << "\n";
+    std::cout << "move latency us  p50: " << percentile(total.latencies, 0.50)
+              << "  p90: " << percentile(total.latencies, 0.90)
+              << "  p99: " << percentile(total.latencies, 0.99)
+              << "  max: " << (total.latencies.empty() ? 0 : total.latencies.back()) << "\n";
+    return (total.errors > 0 || total.dropped > 0) ? 1 : 0;
+}
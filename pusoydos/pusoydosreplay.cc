@@ -0,0 +1,118 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GameRecord.h"
+#include "Replay.h"
+
+using namespace pusoydos;
+
+static void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " <record file> [-g game id [-t turn]]\n";
+    std::cerr << "checks every recorded game, or shows one game at a turn\n";
+}
+
+static void
+printState(std::ostream& os, const Replay& replay, const Rules& rules)
+{
+    const GameState& state = replay.getState();
+    os << "turn " << replay.getTurn() << " of " << replay.getNumTurns() << "\n";
+    for (uint16_t i = 0; i < state.numPlayers; ++i) {
+        const CardSet& hand = replay.getHand(i);
+        os << "seat " << i+1 << ": ";
+        for (uint16_t k = 0; k < hand.size(); ++k) {
+            std::ostringstream oss;
+            rules.getCard(hand.nth(k))->printToStream(oss);
+            os << std::setw(5) << oss.str();
+        }
+        os << "\n";
+    }
+    os << "leader: seat " << state.leadPlayer+1 << "\n";
+    if (state.combo.getSize() > 0) {
+        state.combo.printToStream(os, rules, "to beat");
+    }
+    if (replay.getTurn() < replay.getNumTurns()) {
+        Combo next = GameRecord::decodeTurn(replay.getNextTurn());
+        std::ostringstream owner;
+        owner << "next: seat " << next.getOwner()+1;
+        if (next.getSize() == 0) {
+            os << std::setw(20) << std::right << owner.str() << " | pass\n";
+        }
+        else {
+            next.printToStream(os, rules, owner.str());
+        }
+    }
+    else if (replay.isFinished()) {
+        os << "seat " << replay.getWinner()+1 << " won " << replay.getPoints() << " point(s)\n";
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    bool showGame = false;
+    uint64_t gameId = 0;
+    uint16_t turn = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+            gameId = strtoull(argv[++i], NULL, 10);
+            showGame = true;
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            turn = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        GameRecordReader reader(path);
+        GameRecordReader::RecordView record;
+        uint64_t numGames = 0;
+        uint64_t numBad = 0;
+        while (reader.next(record)) {
+            if (showGame) {
+                if (record.header->gameId != gameId) {
+                    continue;
+                }
+                Replay replay(record);
+                replay.seek(std::min(turn, replay.getNumTurns()));
+                printState(std::cout, replay, Rules::standard());
+                return 0;
+            }
+            ++numGames;
+            try {
+                Replay replay(record);
+                if (!replay.matches(*record.header)) {
+                    std::cout << "game " << record.header->gameId << ": result does not match record\n";
+                    ++numBad;
+                }
+            }
+            catch (const std::runtime_error& e) {
+                std::cout << "game " << record.header->gameId << ": " << e.what() << "\n";
+                ++numBad;
+            }
+        }
+        if (showGame) {
+            std::cerr << "game " << gameId << " not found\n";
+            return 1;
+        }
+        std::cout << "games: " << numGames << "  mismatches: " << numBad << "\n";
+        return (numBad == 0) ? 0 : 2;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "replay failed: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <stdexcept>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Simulator.h"
+#include "TableServer.h"
+
+using namespace pusoydos;
+
+static TableServer* sServer = NULL;
+
+static void
+onSignal(int)
+{
+    if (sServer) {
+        sServer->stop();
+    }
+}
+
+static void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " (-u socket path | -P port) [-p remote,cpu:20:50000,cpu:20:50000,cpu:20:50000] [-s seed] [-t loops (0 = all cores)]\n";
+    std::cerr << "one table per connection, the client plays the remote seat (line protocol in Table.h)\n";
+    std::cerr << "player types: cpu (heuristic only), cpu:<endgame cards>[:<endgame nodes per move>], ismcts[:<playouts>|:<N>ms][:<search threads>]\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    // the node cap bounds how long a move holds up the loop's other tables
+    std::string lineup = "remote,cpu:20:50000,cpu:20:50000,cpu:20:50000";
+    std::string path;
+    uint16_t port = 0;
+    uint32_t seed = 1;
+    uint16_t numLoops = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-u") == 0 && i+1 < argc) {
+            path = argv[++i];
+        }
+        else if (strcmp(argv[i], "-P") == 0 && i+1 < argc) {
+            port = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            lineup = argv[++i];
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            numLoops = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty() == (port == 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        TableServer server(Simulator::parseLineup(lineup), seed, numLoops);
+        if (!path.empty()) {
+            server.listenUnix(path);
+        }
+        else {
+            server.listenTcp(port);
+        }
+        sServer = &server;
+        signal(SIGINT, onSignal);
+        signal(SIGTERM, onSignal);
+        std::cerr << "serving on " << (path.empty() ? "127.0.0.1:" + std::to_string(port) : path)
+                  << " with " << server.getNumLoops() << " loops\n";
+        server.run();
+        sServer = NULL;
+        server.printSummary(std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "server failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
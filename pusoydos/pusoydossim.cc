@@ -0,0 +1,87 @@
+#include <iostream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Simulator.h"
+#include "Stats.h"
+
+using namespace pusoydos;
+
+static void
+usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [-p cpu,cpu,cpu,cpu] [-n games] [-s seed] [-f first game] [-t threads (0 = all cores)] [-o record file] [-S stats file (- for stderr)]\n";
+    std::cerr << "       [-l transcript file] [-L block|drop (when the transcript writer falls behind)]\n";
+    std::cerr << "       [-d (duplicate: every deal with every arrangement of the lineup, -n counts deals)]\n";
+    std::cerr << "player types: cpu (heuristic only), cpu:<endgame cards (at most 20)>[:<endgame nodes per move> (default 1600000)], ismcts[:<playouts>|:<N>ms][:<search threads>]\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string lineup = "cpu,cpu,cpu,cpu";
+    uint64_t numGames = 100000;
+    uint32_t seed = 1;
+    uint64_t firstGame = 0;
+    uint16_t numThreads = 0;
+    std::string recordFile;
+    std::string transcriptFile;
+    AsyncLogWriter::OverflowT transcriptPolicy = AsyncLogWriter::kBlock;
+    bool duplicate = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            lineup = argv[++i];
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            numGames = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            firstGame = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            numThreads = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+            recordFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            transcriptFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "-L") == 0 && i+1 < argc && strcmp(argv[i+1], "block") == 0) {
+            transcriptPolicy = AsyncLogWriter::kBlock;
+            ++i;
+        }
+        else if (strcmp(argv[i], "-L") == 0 && i+1 < argc && strcmp(argv[i+1], "drop") == 0) {
+            transcriptPolicy = AsyncLogWriter::kDrop;
+            ++i;
+        }
+        else if (strcmp(argv[i], "-d") == 0) {
+            duplicate = true;
+        }
+        else if (strcmp(argv[i], "-S") == 0 && i+1 < argc) {
+            Stats::dumpAtExit(argv[++i]);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        Simulator sim(Simulator::parseLineup(lineup), numGames, seed, numThreads, firstGame);
+        sim.setRecordFile(recordFile);
+        sim.setTranscriptFile(transcriptFile, transcriptPolicy);
+        sim.setDuplicate(duplicate);
+        sim.run();
+        sim.printSummary(std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "simulation failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}